@@ -1,15 +1,69 @@
 #include "autocompleter.h"
 
+#include <QAbstractItemView>
+
 #include <autocompletermodel.h>
+#include <completionengine.h>
 
 Autocompleter::Autocompleter(DocumentLabelIndex* labelIndex, QObject* parent) :
     QCompleter(parent),
-    model(new AutocompleterModel(labelIndex, this))
+    candidates(new AutocompleterModel(labelIndex, this)),
+    engine(new CompletionEngine(candidates, this)),
+    patternChanged(false)
 {
-    setModel(model);
+    setModel(engine);
+    setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    setCaseSensitivity(Qt::CaseInsensitive);
+
+    // Matching that runs past its time budget finishes later and updates the
+    // list while the popup is open
+    connect(engine, SIGNAL(completionsAboutToChange()), this, SLOT(onCompletionsAboutToChange()));
+    connect(engine, SIGNAL(completionsChanged()), this, SLOT(onCompletionsChanged()));
 }
 
 Autocompleter::~Autocompleter()
 {
-    delete model;
+    delete engine;
+    delete candidates;
+}
+
+QString Autocompleter::pattern() const
+{
+    return engine->pattern();
+}
+
+void Autocompleter::setPattern(const QString& pattern, int cursorLine)
+{
+    // Typing starts over from the best match
+    patternChanged = true;
+    engine->setPattern(pattern, cursorLine);
+    patternChanged = false;
+}
+
+QString Autocompleter::bestCompletion() const
+{
+    return engine->completionAt(0);
+}
+
+void Autocompleter::onCompletionsAboutToChange()
+{
+    // Remember the selection by its text. QCompleter resets its own model
+    // whenever ours changes, so the popup's current index doesn't survive
+    const QModelIndex current = popup()->currentIndex();
+    if (patternChanged || !current.isValid() || current.row() == 0)
+        selectedCompletion.clear();
+    else
+        selectedCompletion = current.data().toString();
+}
+
+void Autocompleter::onCompletionsChanged()
+{
+    // The best match is always the first row, unless the user has moved
+    // off it to something that is still in the list
+    int row = selectedCompletion.isEmpty() ? 0 : engine->indexOfCompletion(selectedCompletion);
+    if (row < 0) {
+        row = 0;
+        selectedCompletion.clear();
+    }
+    popup()->setCurrentIndex(completionModel()->index(row, 0));
 }
@@ -3,8 +3,12 @@
 
 #include <QCompleter>
 
+class AutocompleterModel;
+class CompletionEngine;
 class DocumentLabelIndex;
 
+// Pops up the completions ranked by a CompletionEngine. The completer does no
+// filtering of its own; the engine's results are shown as they are
 class Autocompleter : public QCompleter
 {
     Q_OBJECT
@@ -12,8 +16,22 @@ public:
     explicit Autocompleter(DocumentLabelIndex* labelIndex, QObject* parent = 0);
     ~Autocompleter();
 
+    QString pattern() const;
+    void setPattern(const QString& pattern, int cursorLine);
+    QString bestCompletion() const;
+
+private slots:
+    void onCompletionsAboutToChange();
+    void onCompletionsChanged();
+
 private:
-    QAbstractItemModel* model;
+    AutocompleterModel* candidates;
+    CompletionEngine* engine;
+
+    // What the user moved the popup to, kept across slices of matching for
+    // the same pattern. Empty while the best match is selected
+    QString selectedCompletion;
+    bool patternChanged;
 };
 
 #endif // AUTOCOMPLETER_H
@@ -28,14 +28,16 @@
 #include <QFontMetrics>
 #include <QMessageBox>
 #include <QPainter>
+#include <QProgressDialog>
 #include <QScrollBar>
-#include <QStringListModel>
 #include <QTextCursor>
 #include <QTextDocument>
-#include <QTextStream>
 
 #include "autocompleter.h"
 #include "linenumberarea.h"
+#include <documentsaver.h>
+#include <editjournal.h>
+#include <fileloader.h>
 #include <syntaxhighlighter.h>
 
 CodeEditWidget::CodeEditWidget(QWidget* parent) :
@@ -43,6 +45,10 @@ CodeEditWidget::CodeEditWidget(QWidget* parent) :
     highlighter(NULL),
     labelIndexer(NULL),
     autocompleter(NULL),
+    loader(NULL),
+    loadProgress(NULL),
+    saver(NULL),
+    journal(NULL),
     firstSelectedLine(0),
     lastSelectedLine(0)
 {
@@ -52,11 +58,20 @@ CodeEditWidget::CodeEditWidget(QWidget* parent) :
     setupIntellisense();
     connectSignalsAndSlots();
 
+    journal = new EditJournal(document(), this);
+    saver = new DocumentSaver(document(), this);
+    connect(saver, SIGNAL(saveFinished(bool)), this, SLOT(onSaveFinished(bool)));
+
     updateLineNumberAreaWidth();
 }
 
 CodeEditWidget::~CodeEditWidget()
 {
+    // Let a save already writing land, but don't report on it, restart the
+    // journal or start a queued save from a widget that is going away
+    delete saver;
+    saver = NULL;
+
     delete lineNumberArea;
     lineNumberArea = NULL;
     if (labelIndexer)
@@ -117,6 +132,21 @@ bool CodeEditWidget::load()
     return loadFile(fileBeingEdited);
 }
 
+bool CodeEditWidget::isLoading() const
+{
+    return loader != NULL;
+}
+
+bool CodeEditWidget::isSaving() const
+{
+    return saver->isSaving();
+}
+
+bool CodeEditWidget::waitForSave()
+{
+    return saver->wait();
+}
+
 void CodeEditWidget::lineNumberAreaPaintEvent(QPaintEvent* event)
 {
     // This is where we do all the magic of drawing the line numbers
@@ -179,12 +209,26 @@ void CodeEditWidget::highlightLines(int startLine, int endLine)
     setTextCursor(selection);
 }
 
+void CodeEditWidget::cancelLoad()
+{
+    if (loader)
+        loader->cancel();
+}
+
 void CodeEditWidget::closeEvent(QCloseEvent* event)
 {
-    if (maybeSave())
+    if (maybeSave()) {
+        // Closing part way through a load just stops it
+        if (loader)
+            finishLoad();
+        waitForSave();
+
+        // Whatever was worth keeping has been saved by now
+        journal->discard();
         event->accept();
-    else
+    } else {
         event->ignore();
+    }
 }
 
 void CodeEditWidget::resizeEvent(QResizeEvent* event)
@@ -224,16 +268,14 @@ void CodeEditWidget::keyPressEvent(QKeyEvent* event)
 
     if (!isShortcut && (hasModifier || event->text().isEmpty() || completionPrefix.length() < 2
                         || eow.contains(event->text().right(1))
-                        || autocompleter->currentCompletion() == completionPrefix)) {
+                        || autocompleter->bestCompletion() == completionPrefix)) {
         autocompleter->popup()->hide();
         return;
     }
 
-    if (completionPrefix != autocompleter->completionPrefix()) {
-        autocompleter->setCompletionPrefix(completionPrefix);
-        QModelIndex firstIndex = autocompleter->completionModel()->index(0, 0);
-        autocompleter->popup()->setCurrentIndex(firstIndex);
-        if (autocompleter->completionModel()->data(firstIndex) == completionPrefix)
+    if (completionPrefix != autocompleter->pattern()) {
+        autocompleter->setPattern(completionPrefix, textCursor().blockNumber());
+        if (autocompleter->bestCompletion() == completionPrefix)
             return;
     }
     QRect cr = cursorRect();
@@ -299,6 +341,17 @@ void CodeEditWidget::updateLineNumberArea(const QRect& rect, int dy)
         if (rect.contains(viewport()->rect()))
             updateLineNumberAreaWidth();
     }
+    updateVisibleLines();
+}
+
+void CodeEditWidget::updateVisibleLines()
+{
+    // The highlighter formats what is on screen first and the rest when idle
+    if (highlighter) {
+        const int firstLine = firstVisibleBlock().blockNumber();
+        const int numLines = viewport()->height() / fontMetrics().lineSpacing() + 1;
+        highlighter->setVisibleLines(firstLine, firstLine + numLines);
+    }
 }
 
 void CodeEditWidget::highlightCurrentLine()
@@ -374,6 +427,7 @@ void CodeEditWidget::setupIntellisense()
 
     if (labelIndexer) {
         DocumentTokenizer* tokenizer = labelIndexer->tokenizer();
+        tokenizer->setBackgroundParsingEnabled(true);
         connect(tokenizer, SIGNAL(tokensAdded(TokenList,int)), this,
                 SLOT(onTokensAdded(TokenList,int)));
         connect(tokenizer, SIGNAL(tokensRemoved(TokenList,int)), this,
@@ -383,8 +437,6 @@ void CodeEditWidget::setupIntellisense()
     if (autocompleter) {
         autocompleter->setWidget(this);
         autocompleter->popup()->setFont(font());
-        autocompleter->setCompletionMode(QCompleter::PopupCompletion);
-        autocompleter->setCaseSensitivity(Qt::CaseInsensitive);
         connect(autocompleter, SIGNAL(activated(QString)),
                 this, SLOT(insertCompletion(QString)));
     }
@@ -404,7 +456,7 @@ bool CodeEditWidget::maybeSave()
     switch (ret)
     {
     case QMessageBox::Save:
-        return save();
+        return save() && waitForSave();
     case QMessageBox::Cancel:
         return false;
     default:
@@ -416,57 +468,76 @@ bool CodeEditWidget::maybeSave()
 
 bool CodeEditWidget::saveFile(const QString& fileName)
 {
-    QFile file(fileName);
-    if (!file.open(QFile::WriteOnly | QFile::Text))
-    {
+    // Saving now would cut the file short
+    if (isLoading()) {
         QMessageBox::warning(this, tr("asIDE"),
-                             tr("Cannot write file %1:\n%2.")
-                             .arg(QDir::toNativeSeparators(fileName),
-                                  file.errorString()));
+                             tr("%1 is still loading.").arg(this->fileName()));
         return false;
     }
 
-#ifndef QT_NO_CURSOR
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-#endif
-
-    QTextStream out(&file);
-    out << toPlainText();
-
-#ifndef QT_NO_CURSOR
-    QApplication::restoreOverrideCursor();
-#endif
+    saver->save(fileName);
+    return true;
+}
 
-    fileBeingEdited = fileName;
-    document()->setModified(false);
+void CodeEditWidget::onSaveFinished(bool succeeded)
+{
+    if (succeeded) {
+        fileBeingEdited = saver->fileName();
+        startJournal();
+    } else {
+        QMessageBox::warning(this, tr("asIDE"),
+                             tr("Cannot write file %1:\n%2.")
+                             .arg(QDir::toNativeSeparators(saver->fileName()),
+                                  saver->errorString()));
+    }
 
-    return true;
+    emit saveFinished(succeeded);
 }
 
 bool CodeEditWidget::loadFile(const QString& fileName)
 {
+    if (loader)
+        finishLoad();
+    journal->stop();
     clear();
 
     if (!fileName.isEmpty()) {
-        QFile file(fileName);
-        if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        FileLoader* fileLoader = new FileLoader(fileName, this);
+        if (!fileLoader->open()) {
             QMessageBox::warning(this, tr("asIDE"),
                                  tr("Cannot read file %1:\n%2.")
-                                 .arg(QDir::toNativeSeparators(fileName), file.errorString()));
+                                 .arg(QDir::toNativeSeparators(fileName), fileLoader->errorString()));
+            delete fileLoader;
             return false;
         }
 
-#ifndef QT_NO_CURSOR
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-#endif
-
-        QTextStream in(&file);
-        setPlainText(in.readAll());
-        highlighter->rehighlight();
-
-#ifndef QT_NO_CURSOR
-    QApplication::restoreOverrideCursor();
-#endif
+        loader = fileLoader;
+        connect(loader, SIGNAL(chunkLoaded(QString)), this, SLOT(onChunkLoaded(QString)));
+        connect(loader, SIGNAL(progress(qint64,qint64)), this, SLOT(onLoadProgress(qint64,qint64)));
+        connect(loader, SIGNAL(finished()), this, SLOT(onLoadFinished()));
+        connect(loader, SIGNAL(cancelled()), this, SLOT(onLoadCancelled()));
+        connect(loader, SIGNAL(failed()), this, SLOT(onLoadFailed()));
+
+        // The file is appended a chunk at a time, so keep anything from being
+        // typed or undone in between
+        setReadOnly(true);
+        document()->setUndoRedoEnabled(false);
+
+        // Only shows up if the load is still going after PROGRESS_DELAY
+        loadProgress = new QProgressDialog(tr("Loading %1...").arg(QFileInfo(fileName).fileName()),
+                                           tr("Cancel"), 0, loader->isSequential() ? 0 : 100, this);
+        loadProgress->setMinimumDuration(PROGRESS_DELAY);
+        connect(loadProgress, SIGNAL(canceled()), this, SLOT(cancelLoad()));
+
+        // Loading highlights what is on screen, with every label known, and
+        // leaves the rest of the file for idle time
+        updateVisibleLines();
+        fileBeingEdited = fileName;
+
+        // The first chunk goes in before returning, so the top of the file
+        // is there to paint straight away
+        loader->start();
+        return true;
     }
 
     fileBeingEdited = fileName;
@@ -474,6 +545,116 @@ bool CodeEditWidget::loadFile(const QString& fileName)
     return true;
 }
 
+void CodeEditWidget::finishLoad()
+{
+    loader->disconnect(this);
+    loader->cancel();
+    loader->deleteLater();
+    loader = NULL;
+
+    if (loadProgress) {
+        loadProgress->disconnect(this);
+        loadProgress->deleteLater();
+        loadProgress = NULL;
+    }
+
+    document()->setUndoRedoEnabled(true);
+    document()->setModified(false);
+    setReadOnly(false);
+}
+
+void CodeEditWidget::onChunkLoaded(const QString& text)
+{
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
+
+    // Nothing has been edited yet, it just hasn't all been read in
+    document()->setModified(false);
+}
+
+void CodeEditWidget::onLoadProgress(qint64 bytesLoaded, qint64 size)
+{
+    if (loadProgress && size > 0)
+        loadProgress->setValue(static_cast<int>(bytesLoaded * 100 / size));
+}
+
+void CodeEditWidget::startJournal()
+{
+    if (fileBeingEdited.isEmpty())
+        return;
+
+    // A file saved under a new name gets a new journal
+    const QString journalFile = EditJournal::journalFileFor(fileBeingEdited);
+    if (journal->journalFile() != journalFile)
+        journal->discard();
+    journal->start(journalFile, fileBeingEdited);
+}
+
+QString CodeEditWidget::unsavedChangesFromJournal() const
+{
+    const QString text = toPlainText();
+    QString recovered = text;
+    if (!EditJournal::replay(EditJournal::journalFileFor(fileBeingEdited), fileBeingEdited, &recovered)
+            || recovered == text)
+        return QString();
+    return recovered;
+}
+
+void CodeEditWidget::onLoadFinished()
+{
+    finishLoad();
+
+    // A journal left behind means the editor went down with unsaved edits.
+    // It stays as it is until the user has decided, so a crash meanwhile
+    // loses nothing
+    const QString recovered = unsavedChangesFromJournal();
+    if (!recovered.isNull()) {
+        const QMessageBox::StandardButton ret
+            = QMessageBox::question(this, tr("asIDE"),
+                                    fileName().append(
+                                       tr(" has unsaved changes from a session that did not close properly.\n"
+                                          "Do you want to recover them?")),
+                                    QMessageBox::Yes | QMessageBox::No);
+        if (ret == QMessageBox::Yes) {
+            // One edit, so it can be undone. The document is modified now,
+            // so the new journal starts with a snapshot of it
+            QTextCursor cursor(document());
+            cursor.select(QTextCursor::Document);
+            cursor.insertText(recovered);
+        }
+    }
+    startJournal();
+
+    emit loadFinished(true);
+}
+
+void CodeEditWidget::onLoadCancelled()
+{
+    abandonLoad();
+    emit loadFinished(false);
+}
+
+void CodeEditWidget::onLoadFailed()
+{
+    const QString error = loader->errorString();
+    abandonLoad();
+
+    QMessageBox::warning(this, tr("asIDE"),
+                         tr("Cannot read file %1:\n%2.")
+                         .arg(QDir::toNativeSeparators(fileBeingEdited), error));
+    emit loadFinished(false);
+}
+
+void CodeEditWidget::abandonLoad()
+{
+    // Whatever was loaded is only part of the file, so don't leave it around
+    // to be edited and saved over the whole thing
+    finishLoad();
+    clear();
+    document()->setModified(false);
+}
+
 QString CodeEditWidget::textUnderCursor() const
 {
     QTextCursor tc = textCursor();
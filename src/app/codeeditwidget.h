@@ -28,12 +28,17 @@
 QT_BEGIN_NAMESPACE
 class QCompleter;
 class QPlainTextEdit;
-class QSyntaxHighlighter;
+class QProgressDialog;
 QT_END_NAMESPACE
 
 #include <documentlabelindex.h>
 
+class Autocompleter;
+class DocumentSaver;
+class EditJournal;
+class FileLoader;
 class LineNumberArea;
+class SyntaxHighlighter;
 
 class CodeEditWidget : public QPlainTextEdit
 {
@@ -54,6 +59,9 @@ public:
 
     void setFileName(const QString& fullFileName);
     bool load();
+    bool isLoading() const;
+    bool isSaving() const;
+    bool waitForSave();
 
     void lineNumberAreaPaintEvent(QPaintEvent* event);
 
@@ -61,6 +69,14 @@ public slots:
     bool save();
     bool saveAs();
     void highlightLines(int startLine, int endLine);
+    void cancelLoad();
+
+signals:
+    // The file named by load() has been read in, or loading it was cancelled or failed
+    void loadFinished(bool completed);
+
+    // A save started by save() or saveAs() has been written out, or failed
+    void saveFinished(bool succeeded);
 
 protected:
     void closeEvent(QCloseEvent* event) Q_DECL_OVERRIDE;
@@ -73,18 +89,30 @@ private slots:
     void onTokensRemoved(const TokenList& tokens, int lineNumber);
     void updateLineNumberAreaWidth();
     void updateLineNumberArea(const QRect& rect, int dy);
+    void updateVisibleLines();
     void highlightCurrentLine();
     void insertCompletion(const QString &completion);
+    void onChunkLoaded(const QString& text);
+    void onLoadProgress(qint64 bytesLoaded, qint64 size);
+    void onLoadFinished();
+    void onLoadCancelled();
+    void onLoadFailed();
+    void onSaveFinished(bool succeeded);
 
 private:
     static const int FONT_SIZE = 14;    // in points
     static const int TAB_WIDTH = 8;     // in spaces
     static const int CURSOR_WIDTH = 2;  // in pixels
+    static const int PROGRESS_DELAY = 500;  // in milliseconds
 
     LineNumberArea* lineNumberArea;
-    QSyntaxHighlighter* highlighter;
+    SyntaxHighlighter* highlighter;
     DocumentLabelIndex* labelIndexer;
-    QCompleter* autocompleter;
+    Autocompleter* autocompleter;
+    FileLoader* loader;
+    QProgressDialog* loadProgress;
+    DocumentSaver* saver;
+    EditJournal* journal;
     QString fileBeingEdited;
     int firstSelectedLine;
     int lastSelectedLine;
@@ -96,6 +124,10 @@ private:
     bool maybeSave();
     bool saveFile(const QString& fileName);
     bool loadFile(const QString& fileName);
+    void finishLoad();
+    void abandonLoad();
+    void startJournal();
+    QString unsavedChangesFromJournal() const;
     QString textUnderCursor() const;
 };
 
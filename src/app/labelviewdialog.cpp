@@ -71,8 +71,9 @@ void LabelViewDialog::setEditor(CodeEditWidget* newEditor)
         if (indexer) {
             disconnect(indexer, SIGNAL(labelAdded(QString,int)), this, SLOT(onLabelIndexChange()));
             disconnect(indexer, SIGNAL(labelRemoved(QString,int)), this, SLOT(onLabelIndexChange()));
-            disconnect(indexer, SIGNAL(lineAdded(int)), this, SLOT(onLabelIndexChange()));
-            disconnect(indexer, SIGNAL(lineRemoved(int)), this, SLOT(onLabelIndexChange()));
+            disconnect(indexer, SIGNAL(linesAdded(int,int)), this, SLOT(onLabelIndexChange()));
+            disconnect(indexer, SIGNAL(linesRemoved(int,int)), this, SLOT(onLabelIndexChange()));
+            disconnect(indexer, SIGNAL(referencesChanged(QString)), this, SLOT(onLabelIndexChange()));
         }
     }
 
@@ -88,8 +89,9 @@ void LabelViewDialog::setEditor(CodeEditWidget* newEditor)
         if (indexer) {
             connect(indexer, SIGNAL(labelAdded(QString,int)), this, SLOT(onLabelIndexChange()));
             connect(indexer, SIGNAL(labelRemoved(QString,int)), this, SLOT(onLabelIndexChange()));
-            connect(indexer, SIGNAL(lineAdded(int)), this, SLOT(onLabelIndexChange()));
-            connect(indexer, SIGNAL(lineRemoved(int)), this, SLOT(onLabelIndexChange()));
+            connect(indexer, SIGNAL(linesAdded(int,int)), this, SLOT(onLabelIndexChange()));
+            connect(indexer, SIGNAL(linesRemoved(int,int)), this, SLOT(onLabelIndexChange()));
+            connect(indexer, SIGNAL(referencesChanged(QString)), this, SLOT(onLabelIndexChange()));
         }
     } else {
         labelModel.setStringList(QStringList());
@@ -122,12 +124,16 @@ void LabelViewDialog::updateLabels()
     if (editor) {
         DocumentLabelIndex* indexer = editor->labelIndex();
         if (indexer) {
-            QStringList labels = indexer->labels();
-            QStringList::iterator i;
-            for (i = labels.begin(); i != labels.end(); ++i) {
-                QString& label = *i;
-                const int lineNumberOfLabel = indexer->lineNumberOfLabel(label);
-                label.insert(0, QString("%1: ").arg(lineNumberOfLabel));
+            SymbolTable* symbols = SymbolTable::instance();
+            QStringList labels;
+            foreach (SymbolId symbol, indexer->labelSymbols()) {
+                QString label = QString("%1: %2 (%3 uses)")
+                        .arg(indexer->lineNumberOfLabel(symbol))
+                        .arg(symbols->name(symbol))
+                        .arg(indexer->numReferences(symbol));
+                if (indexer->isDuplicateLabel(symbol))
+                    label.append(" (duplicate)");
+                labels.push_back(label);
             }
             std::sort(labels.begin(), labels.end());
             labelModel.setStringList(labels);
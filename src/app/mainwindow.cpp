@@ -115,8 +115,8 @@ void MainWindow::open()
 bool MainWindow::save()
 {
     if (currentEditor->save()) {
-        updateCurrentFile();
-        statusBar()->showMessage(tr("File saved"), 2000);
+        if (currentEditor->isSaving())
+            statusBar()->showMessage(tr("Saving..."));
         return true;
     }
     return false;
@@ -125,8 +125,8 @@ bool MainWindow::save()
 bool MainWindow::saveAs()
 {
     if (currentEditor->saveAs()) {
-        updateCurrentFile();
-        statusBar()->showMessage(tr("File saved"), 2000);
+        if (currentEditor->isSaving())
+            statusBar()->showMessage(tr("Saving..."));
         return true;
     }
     return false;
@@ -226,6 +226,10 @@ bool MainWindow::assemble()
 #if defined(Q_OS_LINUX) || defined(Q_OS_WIN)
     statusBar()->showMessage(tr("Assembling file..."));
 
+    // ase100 reads the file from disk, so let any save in progress land first
+    if (currentEditor)
+        currentEditor->waitForSave();
+
     if (currentFile.contains("untitled")) {
         QMessageBox::warning(this, tr("ase100"),
                              tr("Unable to assemble untitled file.\n"
@@ -406,6 +410,40 @@ void MainWindow::onModifyCurrentFile()
     updateCurrentFile();
 }
 
+void MainWindow::onEditorSaveFinished(bool succeeded)
+{
+    CodeEditWidget* codeEdit = qobject_cast<CodeEditWidget*>(sender());
+    if (!codeEdit)
+        return;
+
+    if (codeEdit == currentEditor)
+        updateCurrentFile();
+
+    if (succeeded)
+        statusBar()->showMessage(tr("File saved"), 2000);
+    else
+        statusBar()->showMessage(tr("Failed to save ") + codeEdit->fullFileName(), 3000);
+}
+
+void MainWindow::onEditorLoadFinished(bool completed)
+{
+    CodeEditWidget* codeEdit = qobject_cast<CodeEditWidget*>(sender());
+    if (!codeEdit)
+        return;
+
+    if (completed) {
+        statusBar()->showMessage(tr("Loaded ") + codeEdit->fullFileName(), 2000);
+        if (codeEdit == currentEditor)
+            updateCurrentFile();
+    } else {
+        // A cancelled or failed load leaves nothing worth keeping open
+        statusBar()->showMessage(tr("Did not finish loading ") + codeEdit->fullFileName(), 3000);
+        const int index = ui->tabWidget->indexOf(codeEdit);
+        if (index >= 0)
+            closeTab(index);
+    }
+}
+
 void MainWindow::connectSignalsAndSlots()
 {
     // Pair each action with a corresponding behavior in the MainWindow
@@ -534,10 +572,14 @@ void MainWindow::loadFile(const QString& fileName)
         codeEdit = new CodeEditWidget();
 
     codeEdit->setFileName(fileName);
+    connect(codeEdit, SIGNAL(loadFinished(bool)), this, SLOT(onEditorLoadFinished(bool)),
+            Qt::UniqueConnection);
+    connect(codeEdit, SIGNAL(saveFinished(bool)), this, SLOT(onEditorSaveFinished(bool)),
+            Qt::UniqueConnection);
 
     if (codeEdit->load()) {
-        if (!fileName.isEmpty())
-            statusBar()->showMessage(tr("Loaded ") + fileName, 2000);
+        if (!fileName.isEmpty() && codeEdit->isLoading())
+            statusBar()->showMessage(tr("Loading ") + fileName);
 
         setEditor(codeEdit);
 
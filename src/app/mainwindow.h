@@ -77,6 +77,8 @@ private slots:
     void pickMeUp();
 
     void onModifyCurrentFile();
+    void onEditorLoadFinished(bool completed);
+    void onEditorSaveFinished(bool succeeded);
 
 private:
     Ui::MainWindow* ui;
@@ -24,6 +24,7 @@
 #include "ui_tokenviewdialog.h"
 
 #include <QSettings>
+#include <QTimer>
 
 #include "codeeditwidget.h"
 #include <documenttokenizer.h>
@@ -31,7 +32,9 @@
 TokenViewDialog::TokenViewDialog(QWidget* parent, CodeEditWidget* editor) :
     QDialog(parent),
     ui(new Ui::TokenViewDialog),
-    editor(NULL)
+    editor(NULL),
+    shownGeneration(-1),
+    updateScheduled(false)
 {
     ui->setupUi(this);
     ui->listView->setModel(&tokenModel);
@@ -74,6 +77,7 @@ void TokenViewDialog::setEditor(CodeEditWidget* newEditor)
     }
 
     editor = newEditor;
+    shownGeneration = -1;
 
     if (editor) {
         QString fileName(editor->fileName());
@@ -108,30 +112,44 @@ void TokenViewDialog::closeEvent(QCloseEvent* e)
 
 void TokenViewDialog::onTokensAdded()
 {
-    if (isVisible())
-        updateTokens();
+    scheduleUpdate();
 }
 
 void TokenViewDialog::onTokensRemoved()
 {
-    if (isVisible())
-        updateTokens();
+    scheduleUpdate();
+}
+
+void TokenViewDialog::scheduleUpdate()
+{
+    // One edit can add and remove tokens on many lines; catch up on all of them
+    // at once when control returns to the event loop
+    if (isVisible() && !updateScheduled) {
+        updateScheduled = true;
+        QTimer::singleShot(0, this, SLOT(updateTokens()));
+    }
 }
 
 void TokenViewDialog::updateTokens()
 {
+    updateScheduled = false;
     if (editor) {
         QStringList tokenStrings;
         DocumentLabelIndex* labelIndex = editor->labelIndex();
         if (labelIndex) {
             DocumentTokenizer* tokenizer = labelIndex->tokenizer();
+            // Nothing changed since the list was last built
+            if (tokenizer && tokenizer->generation() == shownGeneration)
+                return;
             if (tokenizer) {
-                for (int i = 0; i < tokenizer->numLines(); ++i) {
-                    TokenList tokensInLine = tokenizer->tokensInLine(i);
-                    foreach (const Token& token, tokensInLine) {
-                        QString tokenString = QString("%1: %2: %3").arg(i).arg(Token::TYPE_NAMES[token.type]).arg(token.value);
-                        tokenStrings.append(tokenString);
-                    }
+                shownGeneration = tokenizer->generation();
+                tokenStrings.reserve(tokenizer->numTokens());
+                DocumentTokenizer::const_iterator token = tokenizer->constBegin();
+                for (; token != tokenizer->constEnd(); ++token) {
+                    QString tokenString = QString("%1: %2: %3").arg(token.lineNumber())
+                            .arg(Token::TYPE_NAMES[token.type()])
+                            .arg(token.value().toString());
+                    tokenStrings.append(tokenString);
                 }
                 tokenModel.setStringList(tokenStrings);
             }
@@ -57,6 +57,12 @@ private:
 
     CodeEditWidget* editor;
     QStringListModel tokenModel;
+
+    // The tokenizer generation the list shows, or -1 if it is out of date
+    int shownGeneration;
+    bool updateScheduled;
+
+    void scheduleUpdate();
 };
 
 #endif // TOKENVIEWDIALOG_H
@@ -3,20 +3,21 @@
 #include <algorithm> //std::sort
 
 #include "documentlabelindex.h"
+#include "mnemonictable.h"
+
+namespace {
+
+bool textLessThan(const QString& a, const QString& b)
+{
+    return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+}
+
+}
 
 AutocompleterModel::AutocompleterModel(DocumentLabelIndex* labelIndex, QObject* parent) :
-    QStringListModel(parent),
+    QAbstractListModel(parent),
     mLabelIndex(NULL)
 {
-    mInstructions << "halt" << "add" << "sub"
-                  << "mult" << "div" << "cp"
-                  << "and" << "or" << "not"
-                  << "sl" << "sr" << "cpfa"
-                  << "cpta" << "be" << "bne"
-                  << "blt" << "call" << "ret"
-                  << "#include";
-    std::sort(mInstructions.begin(), mInstructions.end());
-
     setLabelIndex(labelIndex);
 }
 
@@ -33,9 +34,8 @@ void AutocompleterModel::setLabelIndex(DocumentLabelIndex* labelIndex)
     if (mLabelIndex) {
         connect(mLabelIndex, SIGNAL(labelAdded(QString,int)), this, SLOT(onLabelAdded(QString)));
         connect(mLabelIndex, SIGNAL(labelRemoved(QString,int)), this, SLOT(onLabelRemoved(QString)));
-        mLabels = mLabelIndex->labels();
-        updateStringList();
     }
+    rebuild();
 }
 
 DocumentLabelIndex* AutocompleterModel::labelIndex() const
@@ -43,23 +43,143 @@ DocumentLabelIndex* AutocompleterModel::labelIndex() const
     return mLabelIndex;
 }
 
-void AutocompleterModel::updateStringList()
+int AutocompleterModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : mEntries.size();
+}
+
+QVariant AutocompleterModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= mEntries.size())
+        return QVariant();
+    if (role == Qt::DisplayRole || role == Qt::EditRole)
+        return mEntries[index.row()].text;
+    return QVariant();
+}
+
+QString AutocompleterModel::textAt(int row) const
 {
-    std::sort(mLabels.begin(), mLabels.end());
-    QStringList newList(mInstructions);
-    newList.append(mLabels);
-    setStringList(newList);
+    return mEntries[row].text;
+}
+
+SymbolId AutocompleterModel::labelAt(int row) const
+{
+    return mEntries[row].label;
+}
+
+int AutocompleterModel::firstCompletion(const QString& prefix) const
+{
+    return lowerBound(prefix);
+}
+
+int AutocompleterModel::numCompletions(const QString& prefix) const
+{
+    // Everything starting with the prefix sorts right after it
+    const int first = lowerBound(prefix);
+    int lo = first;
+    int hi = mEntries.size();
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (mEntries[mid].text.startsWith(prefix, Qt::CaseInsensitive))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - first;
+}
+
+QStringList AutocompleterModel::completions(const QString& prefix) const
+{
+    QStringList result;
+    const int first = firstCompletion(prefix);
+    const int count = numCompletions(prefix);
+    for (int i = first; i < first + count; ++i) {
+        result.push_back(mEntries[i].text);
+    }
+    return result;
+}
+
+void AutocompleterModel::rebuild()
+{
+    beginResetModel();
+    mEntries.clear();
+
+    QStringList instructions = MnemonicTable::names();
+    instructions << "#include";
+    foreach (const QString& instruction, instructions) {
+        Entry entry = {instruction, SymbolTable::NO_SYMBOL};
+        mEntries.push_back(entry);
+    }
+
+    if (mLabelIndex) {
+        SymbolTable* symbols = SymbolTable::instance();
+        foreach (SymbolId label, mLabelIndex->labelSymbols()) {
+            Entry entry = {symbols->name(label), label};
+            mEntries.push_back(entry);
+        }
+    }
+
+    std::sort(mEntries.begin(), mEntries.end(), entryLessThan);
+    endResetModel();
+}
+
+bool AutocompleterModel::entryLessThan(const Entry& a, const Entry& b)
+{
+    return textLessThan(a.text, b.text);
+}
+
+int AutocompleterModel::lowerBound(const QString& text) const
+{
+    int lo = 0;
+    int hi = mEntries.size();
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (textLessThan(mEntries[mid].text, text))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+int AutocompleterModel::indexOfLabel(SymbolId label, const QString& text) const
+{
+    // Entries that differ only in case sit next to each other
+    for (int i = lowerBound(text); i < mEntries.size(); ++i) {
+        if (mEntries[i].label == label)
+            return i;
+        if (QString::compare(mEntries[i].text, text, Qt::CaseInsensitive) != 0)
+            break;
+    }
+    return -1;
 }
 
 void AutocompleterModel::onLabelAdded(const QString& label)
 {
-    if (!mLabels.contains(label))
-        mLabels.append(label);
-    updateStringList();
+    // Another definition of a label we already list changes nothing. The
+    // label index keeps the name in the SymbolTable for as long as we list it
+    const SymbolId symbol = SymbolTable::instance()->find(label);
+    if (indexOfLabel(symbol, label) >= 0)
+        return;
+
+    const int row = lowerBound(label);
+    beginInsertRows(QModelIndex(), row, row);
+    Entry entry = {label, symbol};
+    mEntries.insert(row, entry);
+    endInsertRows();
 }
 
 void AutocompleterModel::onLabelRemoved(const QString& label)
 {
-    mLabels.removeAll(label);
-    updateStringList();
+    // A label defined more than once stays until its last definition goes
+    const SymbolId symbol = SymbolTable::instance()->find(label);
+    if (mLabelIndex && mLabelIndex->hasLabel(symbol))
+        return;
+
+    const int row = indexOfLabel(symbol, label);
+    if (row < 0)
+        return;
+    beginRemoveRows(QModelIndex(), row, row);
+    mEntries.remove(row);
+    endRemoveRows();
 }
@@ -1,11 +1,22 @@
 #ifndef AUTOCOMPLETERMODEL_H
 #define AUTOCOMPLETERMODEL_H
 
-#include <QStringListModel>
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QVector>
+
+#include "symboltable.h"
 
 class DocumentLabelIndex;
 
-class AutocompleterModel : public QStringListModel
+// The instructions and labels offered for completion, as one list kept sorted
+// case-insensitively.
+//
+// Labels are inserted and removed in place with a binary search, so an edit
+// costs O(log n) comparisons plus a single row change, and a completer that is
+// told the model is sorted (QCompleter::CaseInsensitivelySortedModel) can find
+// the completions of a prefix by binary search instead of scanning every row.
+class AutocompleterModel : public QAbstractListModel
 {
     Q_OBJECT
 public:
@@ -14,15 +25,35 @@ public:
     void setLabelIndex(DocumentLabelIndex* labelIndex);
     DocumentLabelIndex* labelIndex() const;
 
+    int rowCount(const QModelIndex& parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+
+    QString textAt(int row) const;
+    SymbolId labelAt(int row) const; // NO_SYMBOL for instructions
+
+    // The rows [first, first + count) that start with prefix, ignoring case
+    int firstCompletion(const QString& prefix) const;
+    int numCompletions(const QString& prefix) const;
+    QStringList completions(const QString& prefix) const;
+
 private slots:
-    void updateStringList();
     void onLabelAdded(const QString& label);
     void onLabelRemoved(const QString& label);
 
 private:
+    struct Entry {
+        QString text;
+        SymbolId label; // NO_SYMBOL for instructions
+    };
+
     DocumentLabelIndex* mLabelIndex;
-    QStringList mInstructions;
-    QStringList mLabels;
+    QVector<Entry> mEntries;
+
+    static bool entryLessThan(const Entry& a, const Entry& b);
+
+    void rebuild();
+    int lowerBound(const QString& text) const;
+    int indexOfLabel(SymbolId label, const QString& text) const;
 };
 
 #endif // AUTOCOMPLETERMODEL_H
@@ -0,0 +1,328 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "completionengine.h"
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTimer>
+
+#include <algorithm> // std::partial_sort
+
+#include "autocompletermodel.h"
+#include "documentlabelindex.h"
+
+namespace {
+
+const int MATCHED_CHAR_SCORE = 10;
+const int BOUNDARY_BONUS = 20;
+const int CONSECUTIVE_BONUS = 15;
+const int PREFIX_BONUS = 30;
+
+// How many candidates to match between looks at the clock
+const int CLOCK_INTERVAL = 64;
+
+bool isWordBoundary(const QString& text, int i)
+{
+    if (i == 0)
+        return true;
+    const QChar previous = text[i - 1];
+    const QChar current = text[i];
+    if (!previous.isLetterOrNumber())
+        return true;
+    if (previous.isLower() && current.isUpper())
+        return true;
+    return previous.isLetter() && current.isDigit();
+}
+
+// The number of bits needed to write n, so roughly log2(n) + 1
+int bitsOf(int n)
+{
+    int bits = 0;
+    while (n > 0) {
+        ++bits;
+        n >>= 1;
+    }
+    return bits;
+}
+
+}
+
+CompletionEngine::CompletionEngine(AutocompleterModel* candidates, QObject* parent) :
+    QAbstractListModel(parent),
+    mCandidates(candidates),
+    mCursorLine(-1),
+    mTimeBudget(DEFAULT_TIME_BUDGET),
+    mScanPosition(0),
+    mNumScannedLastPass(0),
+    mContinueScheduled(false),
+    mCandidatesChanged(true)
+{
+    connect(mCandidates, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(onCandidatesChanged()));
+    connect(mCandidates, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(onCandidatesChanged()));
+    connect(mCandidates, SIGNAL(modelReset()), this, SLOT(onCandidatesChanged()));
+}
+
+AutocompleterModel* CompletionEngine::candidates() const
+{
+    return mCandidates;
+}
+
+QString CompletionEngine::pattern() const
+{
+    return mPattern;
+}
+
+void CompletionEngine::setPattern(const QString& pattern, int cursorLine)
+{
+    // Anything that matches the new pattern also matched the one it extends,
+    // so only those candidates (and any we never got to) need another look
+    const bool narrows = !mCandidatesChanged && !mPattern.isEmpty() &&
+            pattern.startsWith(mPattern, Qt::CaseInsensitive);
+
+    QVector<int> pool;
+    if (narrows) {
+        pool.reserve(mMatches.size() + mPool.size() - mScanPosition);
+        foreach (const Match& match, mMatches) {
+            pool.push_back(match.row);
+        }
+        for (int i = mScanPosition; i < mPool.size(); ++i) {
+            pool.push_back(mPool[i]);
+        }
+    } else {
+        const int numCandidates = mCandidates->rowCount();
+        pool.resize(numCandidates);
+        for (int row = 0; row < numCandidates; ++row) {
+            pool[row] = row;
+        }
+        mCandidatesChanged = false;
+    }
+
+    mPattern = pattern;
+    mCursorLine = cursorLine;
+    mPool.swap(pool);
+    mScanPosition = 0;
+    mMatches.clear();
+    scan();
+}
+
+int CompletionEngine::timeBudget() const
+{
+    return mTimeBudget;
+}
+
+void CompletionEngine::setTimeBudget(int microseconds)
+{
+    mTimeBudget = microseconds;
+}
+
+bool CompletionEngine::isComplete() const
+{
+    return mScanPosition >= mPool.size();
+}
+
+int CompletionEngine::numMatches() const
+{
+    return mMatches.size();
+}
+
+int CompletionEngine::numScannedLastPass() const
+{
+    return mNumScannedLastPass;
+}
+
+QString CompletionEngine::completionAt(int row) const
+{
+    return mResults.value(row);
+}
+
+int CompletionEngine::indexOfCompletion(const QString& completion) const
+{
+    return mResults.indexOf(completion);
+}
+
+int CompletionEngine::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : mResults.size();
+}
+
+QVariant CompletionEngine::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= mResults.size())
+        return QVariant();
+    if (role == Qt::DisplayRole || role == Qt::EditRole)
+        return mResults[index.row()];
+    return QVariant();
+}
+
+int CompletionEngine::matchScore(const QString& pattern, const QString& candidate)
+{
+    // Match each character of the pattern at its first occurrence after the
+    // previous one
+    int score = 0;
+    int previousMatch = -1;
+    int i = 0;
+    foreach (const QChar c, pattern) {
+        const QChar folded = c.toCaseFolded();
+        while (i < candidate.size() && candidate[i].toCaseFolded() != folded)
+            ++i;
+        if (i == candidate.size())
+            return -1;
+
+        score += MATCHED_CHAR_SCORE;
+        if (isWordBoundary(candidate, i))
+            score += BOUNDARY_BONUS;
+        if (i == previousMatch + 1 && previousMatch >= 0)
+            score += CONSECUTIVE_BONUS;
+        score -= i - previousMatch - 1; // the characters skipped to get here
+        previousMatch = i++;
+    }
+
+    if (previousMatch == pattern.size() - 1)
+        score += PREFIX_BONUS;
+
+    // Between equal matches, the shorter candidate is the better one. A poor
+    // match is still a match, so the score never drops below zero
+    score -= candidate.size() - pattern.size();
+    return qMax(0, score);
+}
+
+void CompletionEngine::continueMatching()
+{
+    mContinueScheduled = false;
+    if (!isComplete())
+        scan();
+}
+
+void CompletionEngine::onCandidatesChanged()
+{
+    // Rows have moved, so the rows we remember are meaningless. Start from
+    // scratch on the next pattern and keep showing the results we have
+    mCandidatesChanged = true;
+    mPool.clear();
+    mScanPosition = 0;
+    mMatches.clear();
+}
+
+void CompletionEngine::scan()
+{
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 budget = qint64(mTimeBudget) * 1000;
+
+    int scanned = 0;
+    while (mScanPosition < mPool.size()) {
+        const int row = mPool[mScanPosition++];
+        const int score = matchScore(mPattern, mCandidates->textAt(row));
+        if (score >= 0) {
+            Match match = {row, score + contextScore(row)};
+            mMatches.push_back(match);
+        }
+
+        ++scanned;
+        if (scanned % CLOCK_INTERVAL == 0 && timer.nsecsElapsed() >= budget)
+            break;
+    }
+    mNumScannedLastPass = scanned;
+
+    publishResults();
+
+    if (!isComplete() && !mContinueScheduled) {
+        mContinueScheduled = true;
+        QTimer::singleShot(0, this, SLOT(continueMatching()));
+    }
+}
+
+void CompletionEngine::publishResults()
+{
+    const int numResults = qMin(int(MAX_RESULTS), mMatches.size());
+    std::partial_sort(mMatches.begin(), mMatches.begin() + numResults, mMatches.end(), matchLessThan);
+
+    QStringList results;
+    for (int i = 0; i < numResults; ++i) {
+        results.push_back(mCandidates->textAt(mMatches[i].row));
+    }
+
+    emit completionsAboutToChange();
+
+    // Turn the old results into the new ones a row at a time, so that rows
+    // still in the results keep their place in any view. Drop the rows that
+    // fell out first, then move or insert the rest into order
+    const QSet<QString> kept = results.toSet();
+    for (int row = mResults.size() - 1; row >= 0; --row) {
+        if (!kept.contains(mResults[row])) {
+            beginRemoveRows(QModelIndex(), row, row);
+            mResults.removeAt(row);
+            endRemoveRows();
+        }
+    }
+
+    for (int row = 0; row < results.size(); ++row) {
+        if (row < mResults.size() && mResults[row] == results[row])
+            continue;
+
+        const int from = mResults.indexOf(results[row], row);
+        if (from >= 0) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+            mResults.move(from, row);
+            endMoveRows();
+        } else {
+            beginInsertRows(QModelIndex(), row, row);
+            mResults.insert(row, results[row]);
+            endInsertRows();
+        }
+    }
+
+    // Only a candidate listed twice could be left over
+    if (mResults.size() > results.size()) {
+        beginRemoveRows(QModelIndex(), results.size(), mResults.size() - 1);
+        mResults.erase(mResults.begin() + results.size(), mResults.end());
+        endRemoveRows();
+    }
+
+    emit completionsChanged();
+}
+
+int CompletionEngine::contextScore(int row) const
+{
+    // Labels defined close to the cursor, and labels used a lot, are the
+    // likelier ones. Both count logarithmically so neither swamps the match
+    const SymbolId label = mCandidates->labelAt(row);
+    const DocumentLabelIndex* labelIndex = mCandidates->labelIndex();
+    if (label == SymbolTable::NO_SYMBOL || !labelIndex)
+        return 0;
+
+    int score = qMin(4 * bitsOf(labelIndex->numReferences(label)), 32);
+    if (mCursorLine >= 0) {
+        const int distance = qAbs(labelIndex->lineNumberOfLabel(label) - mCursorLine);
+        score += qMax(0, 40 - 4 * bitsOf(distance));
+    }
+    return score;
+}
+
+bool CompletionEngine::matchLessThan(const Match& a, const Match& b)
+{
+    // Best score first. Rows are in alphabetical order, so ties stay sorted
+    if (a.score != b.score)
+        return a.score > b.score;
+    return a.row < b.row;
+}
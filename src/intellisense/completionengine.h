@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMPLETIONENGINE_H
+#define COMPLETIONENGINE_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QVector>
+
+#include "intellisense_global.h"
+
+class AutocompleterModel;
+
+// Ranks the instructions and labels of an AutocompleterModel against what the
+// user has typed, and exposes the best of them as a list model for a popup.
+//
+// A candidate matches when the typed characters appear in it in order, so
+// "lpctr" finds "loop_counter". Matches that start the word, land on word
+// boundaries or run together score higher, and labels defined near the cursor
+// or used often are pulled up.
+//
+// Each setPattern() call spends at most timeBudget() microseconds matching.
+// Whatever is left is matched in further slices from the event loop, and the
+// results are updated as they arrive, a row at a time rather than by resetting
+// the model, so a view keeps its place. When the new pattern extends the last
+// one, only the candidates that matched the last one are looked at again.
+class INTELLISENSE_EXPORT CompletionEngine : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static const int MAX_RESULTS = 50;
+    static const int DEFAULT_TIME_BUDGET = 1000; // in microseconds
+
+    explicit CompletionEngine(AutocompleterModel* candidates, QObject* parent = 0);
+
+    AutocompleterModel* candidates() const;
+
+    QString pattern() const;
+    void setPattern(const QString& pattern, int cursorLine = -1);
+
+    int timeBudget() const;
+    void setTimeBudget(int microseconds);
+
+    // False while some candidates are still waiting to be matched
+    bool isComplete() const;
+    int numMatches() const;
+    int numScannedLastPass() const;
+
+    QString completionAt(int row) const;
+    int indexOfCompletion(const QString& completion) const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+
+    // How well pattern matches candidate, ignoring case, or -1 if the
+    // characters of pattern do not all appear in candidate in order
+    static int matchScore(const QString& pattern, const QString& candidate);
+
+signals:
+    void completionsAboutToChange();
+    void completionsChanged();
+
+private slots:
+    void continueMatching();
+    void onCandidatesChanged();
+
+private:
+    struct Match {
+        int row;
+        int score;
+    };
+
+    AutocompleterModel* mCandidates;
+    QString mPattern;
+    int mCursorLine;
+    int mTimeBudget;
+
+    // The candidate rows still to be matched against mPattern, and how far
+    // through them we are
+    QVector<int> mPool;
+    int mScanPosition;
+    int mNumScannedLastPass;
+    bool mContinueScheduled;
+    bool mCandidatesChanged;
+
+    QVector<Match> mMatches;
+    QStringList mResults;
+
+    void scan();
+    void publishResults();
+    int contextScore(int row) const;
+
+    static bool matchLessThan(const Match& a, const Match& b);
+};
+
+#endif // COMPLETIONENGINE_H
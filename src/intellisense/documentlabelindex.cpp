@@ -23,9 +23,13 @@
 #include "documentlabelindex.h"
 
 #include <QDebug>
+#include <QPair>
+
+#include <algorithm> // std::sort
 
 DocumentLabelIndex::DocumentLabelIndex(QTextDocument* doc) :
-    mTokenizer(NULL)
+    mTokenizer(NULL),
+    mSymbols(SymbolTable::instance())
 {
     setDocument(doc);
 }
@@ -34,6 +38,9 @@ DocumentLabelIndex::~DocumentLabelIndex()
 {
     if (mTokenizer)
         delete mTokenizer;
+
+    // Give back the names this index kept in the SymbolTable
+    reset();
 }
 
 QTextDocument* DocumentLabelIndex::document()
@@ -48,10 +55,10 @@ void DocumentLabelIndex::setDocument(QTextDocument* doc)
 {
     // Delete and disconnect the previous tokenizer
     if (mTokenizer) {
-        disconnect(mTokenizer, SIGNAL(tokensAdded(TokenList,int)), this, SLOT(onTokensAdded(TokenList,int)));
-        disconnect(mTokenizer, SIGNAL(tokensRemoved(TokenList,int)), this, SLOT(onTokensRemoved(TokenList,int)));
-        disconnect(mTokenizer, SIGNAL(lineAdded(int)), this, SLOT(onLineAdded(int)));
-        disconnect(mTokenizer, SIGNAL(lineRemoved(int)), this, SLOT(onLineRemoved(int)));
+        disconnect(mTokenizer, SIGNAL(lineChanged(int,TokenLineDiff)), this, SLOT(onLineChanged(int,TokenLineDiff)));
+        disconnect(mTokenizer, SIGNAL(linesParsed(int,int)), this, SLOT(onLinesParsed(int,int)));
+        disconnect(mTokenizer, SIGNAL(linesAdded(int,int)), this, SLOT(onLinesAdded(int,int)));
+        disconnect(mTokenizer, SIGNAL(linesRemoved(int,int)), this, SLOT(onLinesRemoved(int,int)));
 
         delete mTokenizer;
     }
@@ -62,10 +69,10 @@ void DocumentLabelIndex::setDocument(QTextDocument* doc)
 
     // Connect the new tokenizer
     if (mTokenizer) {
-        connect(mTokenizer, SIGNAL(tokensAdded(TokenList,int)), this, SLOT(onTokensAdded(TokenList,int)));
-        connect(mTokenizer, SIGNAL(tokensRemoved(TokenList,int)), this, SLOT(onTokensRemoved(TokenList,int)));
-        connect(mTokenizer, SIGNAL(lineAdded(int)), this, SLOT(onLineAdded(int)));
-        connect(mTokenizer, SIGNAL(lineRemoved(int)), this, SLOT(onLineRemoved(int)));
+        connect(mTokenizer, SIGNAL(lineChanged(int,TokenLineDiff)), this, SLOT(onLineChanged(int,TokenLineDiff)));
+        connect(mTokenizer, SIGNAL(linesParsed(int,int)), this, SLOT(onLinesParsed(int,int)));
+        connect(mTokenizer, SIGNAL(linesAdded(int,int)), this, SLOT(onLinesAdded(int,int)));
+        connect(mTokenizer, SIGNAL(linesRemoved(int,int)), this, SLOT(onLinesRemoved(int,int)));
     } else {
         qDebug() << "Could not allocate new DocumentTokenizer";
     }
@@ -80,71 +87,166 @@ DocumentTokenizer* DocumentLabelIndex::tokenizer()
 
 bool DocumentLabelIndex::hasLabel(const QString& label) const
 {
-    return mLinesByLabel.contains(label);
+    return hasLabel(mSymbols->find(label));
 }
 
 bool DocumentLabelIndex::hasLabelAtLine(int line) const
 {
-    foreach (LabelInfo l, mLinesByLabel) {
-        if (l.lineNumber == line)
-            return true;
-    }
-    return false;
+    return mLabelsByLine.find(line) != NULL;
 }
 
 bool DocumentLabelIndex::hasLabelAtLine(const QString& label, int line) const
 {
-    if (!hasLabel(label))
-        return false;
-    if (!hasLabelAtLine(line))
-        return false;
-    return mLinesByLabel[label].lineNumber == line;
+    return hasLabelAtLine(mSymbols->find(label), line);
 }
 
 bool DocumentLabelIndex::isFunctionLabel(const QString& label) const
 {
-    if (!hasLabel(label))
-        return false;
-    return mLinesByLabel[label].type == FunctionLabel;
+    return isFunctionLabel(mSymbols->find(label));
 }
 
 bool DocumentLabelIndex::isVariableLabel(const QString& label) const
 {
-    if (!hasLabel(label))
-        return false;
-    return mLinesByLabel[label].type == VariableLabel;
+    return isVariableLabel(mSymbols->find(label));
+}
+
+bool DocumentLabelIndex::isDuplicateLabel(const QString& label) const
+{
+    return isDuplicateLabel(mSymbols->find(label));
 }
 
 int DocumentLabelIndex::lineNumberOfLabel(const QString& label) const
 {
-    if (!hasLabel(label))
-        return -1;
-    return mLinesByLabel[label].lineNumber;
+    return lineNumberOfLabel(mSymbols->find(label));
 }
 
-QString DocumentLabelIndex::labelAtLine(int line) const
+QList<int> DocumentLabelIndex::definitionsOfLabel(const QString& label) const
+{
+    return definitionsOfLabel(mSymbols->find(label));
+}
+
+QList<QString> DocumentLabelIndex::duplicateLabels() const
 {
-    QMap<QString, LabelInfo>::const_iterator i;
-    for (i = mLinesByLabel.begin(); i != mLinesByLabel.end(); ++i) {
-        if (i.value().lineNumber == line)
-            return i.key();
+    QList<QString> labels;
+    foreach (SymbolId label, mDuplicateLabels) {
+        labels.push_back(mSymbols->name(label));
     }
-    return QString();
+    std::sort(labels.begin(), labels.end());
+    return labels;
+}
+
+QString DocumentLabelIndex::labelAtLine(int line) const
+{
+    return mSymbols->name(symbolAtLine(line));
 }
 
 QList<QString> DocumentLabelIndex::labels() const
 {
     QList<QString> labels;
-    QMap<QString, LabelInfo>::const_iterator i;
+    QHash<SymbolId, LabelInfos>::const_iterator i;
     for (i = mLinesByLabel.constBegin(); i != mLinesByLabel.constEnd(); ++i) {
-        labels.push_back(i.key());
+        labels.push_back(mSymbols->name(i.key()));
     }
+    std::sort(labels.begin(), labels.end());
     return labels;
 }
 
+QList<int> DocumentLabelIndex::referencesOfLabel(const QString& label) const
+{
+    QList<int> lines;
+    const QSet<ReferenceAnchors::Anchor*> anchors = mReferenceLinesByLabel.value(mSymbols->find(label));
+    foreach (const ReferenceAnchors::Anchor* anchor, anchors) {
+        lines.push_back(mReferencesByLine.lineOf(anchor));
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+int DocumentLabelIndex::numReferences(const QString& label) const
+{
+    return numReferences(mSymbols->find(label));
+}
+
+bool DocumentLabelIndex::hasLabel(SymbolId label) const
+{
+    return mLinesByLabel.contains(label);
+}
+
+bool DocumentLabelIndex::hasLabelAtLine(SymbolId label, int line) const
+{
+    // True for every definition of the label, not just the first
+    const LabelAnchors::Anchor* anchor = mLabelsByLine.find(line);
+    return anchor && anchor->value() == label;
+}
+
+bool DocumentLabelIndex::isFunctionLabel(SymbolId label) const
+{
+    const LabelInfo* info = firstDefinition(label);
+    return info && info->type == FunctionLabel;
+}
+
+bool DocumentLabelIndex::isVariableLabel(SymbolId label) const
+{
+    const LabelInfo* info = firstDefinition(label);
+    return info && info->type == VariableLabel;
+}
+
+bool DocumentLabelIndex::isDuplicateLabel(SymbolId label) const
+{
+    return mDuplicateLabels.contains(label);
+}
+
+int DocumentLabelIndex::lineNumberOfLabel(SymbolId label) const
+{
+    const LabelInfo* info = firstDefinition(label);
+    if (!info)
+        return -1;
+    return mLabelsByLine.lineOf(info->anchor);
+}
+
+QList<int> DocumentLabelIndex::definitionsOfLabel(SymbolId label) const
+{
+    QList<int> lines;
+    foreach (const LabelInfo& info, mLinesByLabel.value(label)) {
+        lines.push_back(mLabelsByLine.lineOf(info.anchor));
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+SymbolId DocumentLabelIndex::symbolAtLine(int line) const
+{
+    const LabelAnchors::Anchor* anchor = mLabelsByLine.find(line);
+    return anchor ? anchor->value() : SymbolTable::NO_SYMBOL;
+}
+
+QList<SymbolId> DocumentLabelIndex::labelSymbols() const
+{
+    return mLinesByLabel.keys();
+}
+
+int DocumentLabelIndex::numReferences(SymbolId label) const
+{
+    return mReferenceLinesByLabel.value(label).size();
+}
+
 void DocumentLabelIndex::reset()
 {
+    // Every definition and every use holds its label's name in the SymbolTable
+    for (QHash<SymbolId, LabelInfos>::const_iterator i = mLinesByLabel.constBegin(); i != mLinesByLabel.constEnd(); ++i) {
+        for (int j = 0; j < i.value().size(); ++j)
+            mSymbols->release(i.key());
+    }
+    for (QHash<SymbolId, QSet<ReferenceAnchors::Anchor*> >::const_iterator i = mReferenceLinesByLabel.constBegin(); i != mReferenceLinesByLabel.constEnd(); ++i) {
+        for (int j = 0; j < i.value().size(); ++j)
+            mSymbols->release(i.key());
+    }
+
     mLinesByLabel.clear();
+    mLabelsByLine.clear();
+    mDuplicateLabels.clear();
+    mReferencesByLine.clear();
+    mReferenceLinesByLabel.clear();
 }
 
 void DocumentLabelIndex::readFromTokenizer()
@@ -153,104 +255,294 @@ void DocumentLabelIndex::readFromTokenizer()
         const int numLines = mTokenizer->numLines();
         for (int i = 0; i < numLines; ++i) {
             readLabelsFromLine(mTokenizer->tokensInLine(i), i);
+            readReferencesFromLine(mTokenizer->tokensInLine(i), i);
         }
     }
 }
 
-void DocumentLabelIndex::readLabelsFromLine(const TokenList& tokensInLine, int line)
+void DocumentLabelIndex::readLabelsFromLine(const TokenLine& tokensInLine, int line)
 {
-    if (!tokensInLine.empty()) {
-        Token firstToken = tokensInLine.first();
-        if (firstToken.type == Token::Label) {
-            QString newLabel = firstToken.value;
-            LabelInfo newLabelInfo = {line, VariableLabel};
+    if (!tokensInLine.isEmpty()) {
+        if (tokensInLine.typeAt(0) == Token::Label) {
+            // addLabel takes over this use of the name
+            const SymbolId newLabel = mSymbols->intern(tokensInLine.valueAt(0).toString());
+            LabelType newLabelType = VariableLabel;
 
             if (tokensInLine.size() >= 2) {
-                Token secondToken = tokensInLine.at(1);
-                if (secondToken.type == Token::Instruction)
-                    newLabelInfo.type = FunctionLabel;
+                if (tokensInLine.typeAt(1) == Token::Instruction)
+                    newLabelType = FunctionLabel;
             }
 
-            addLabel(newLabel, newLabelInfo.lineNumber, newLabelInfo.type);
+            addLabel(newLabel, line, newLabelType);
         }
     }
 }
 
-void DocumentLabelIndex::addLabel(const QString& label, int line, LabelType type)
+void DocumentLabelIndex::readReferencesFromLine(const TokenLine& tokensInLine, int line)
 {
-    qDebug() << "adding label:" << label << "at line:" << line;
+    // Every label after the first token is a use of that label
+    QStringList usedNames;
+    for (int i = 1; i < tokensInLine.size(); ++i) {
+        if (tokensInLine.typeAt(i) == Token::Label) {
+            const QString name = tokensInLine.valueAt(i).toString();
+            if (!usedNames.contains(name))
+                usedNames.push_back(name);
+        }
+    }
 
-    // If we already have this label at this line, make sure it has the right type
-    if (hasLabelAtLine(label, line)) {
-        mLinesByLabel[label].type = type;
+    // Compare without interning, so an unchanged line costs the SymbolTable nothing
+    ReferenceAnchors::Anchor* oldAnchor = mReferencesByLine.find(line);
+    const SymbolList oldLabels = oldAnchor ? oldAnchor->value() : SymbolList();
+    bool unchanged = usedNames.size() == oldLabels.size();
+    for (int i = 0; unchanged && i < usedNames.size(); ++i)
+        unchanged = mSymbols->find(usedNames[i]) == oldLabels[i];
+    if (unchanged)
         return;
+
+    // The new anchor holds one use of each name. They are taken before the old
+    // uses are given back, so a label used both before and after keeps its id
+    SymbolList usedLabels;
+    foreach (const QString& name, usedNames) {
+        usedLabels.push_back(mSymbols->intern(name));
     }
 
-    // Add this label to our data structures
-    LabelInfo newLabelInfo = {line, type};
-    mLinesByLabel[label] = newLabelInfo;
+    QSet<SymbolId> changedLabels;
+    SymbolList releasedLabels;
+    if (oldAnchor)
+        removeReferences(oldAnchor, changedLabels, releasedLabels);
+
+    if (!usedLabels.isEmpty()) {
+        ReferenceAnchors::Anchor* anchor = mReferencesByLine.insert(line, usedLabels);
+        foreach (SymbolId label, usedLabels) {
+            mReferenceLinesByLabel[label].insert(anchor);
+            changedLabels.insert(label);
+        }
+    }
+
+    // A label used both before and after the edit still has the same lines
+    foreach (SymbolId label, changedLabels) {
+        if (!oldLabels.contains(label) || !usedLabels.contains(label))
+            emit referencesChanged(mSymbols->name(label));
+    }
+    releaseSymbols(releasedLabels);
+}
+
+void DocumentLabelIndex::removeReferences(ReferenceAnchors::Anchor* anchor, QSet<SymbolId>& changedLabels, SymbolList& releasedLabels)
+{
+    // The names are released by the caller, once it has said which labels changed
+    releasedLabels += anchor->value();
+    foreach (SymbolId label, anchor->value()) {
+        QHash<SymbolId, QSet<ReferenceAnchors::Anchor*> >::iterator i = mReferenceLinesByLabel.find(label);
+        i.value().remove(anchor);
+        if (i.value().isEmpty())
+            mReferenceLinesByLabel.erase(i);
+        changedLabels.insert(label);
+    }
+    mReferencesByLine.remove(anchor);
+}
 
-    emit labelAdded(label, line);
+void DocumentLabelIndex::releaseSymbols(const SymbolList& labels)
+{
+    foreach (SymbolId label, labels) {
+        mSymbols->release(label);
+    }
 }
 
-void DocumentLabelIndex::removeLabel(const QString& label, int line)
+void DocumentLabelIndex::addLabel(SymbolId label, int line, LabelType type)
 {
-    qDebug() << "removing label:" << label << "at line:" << line;
+    qDebug() << "adding label:" << mSymbols->name(label) << "at line:" << line;
 
-    if (!hasLabelAtLine(label, line))
+    // If we already have this label at this line, make sure it has the right type
+    LabelAnchors::Anchor* anchor = mLabelsByLine.find(line);
+    if (anchor && anchor->value() == label) {
+        LabelInfos& definitions = mLinesByLabel[label];
+        for (int i = 0; i < definitions.size(); ++i) {
+            if (definitions[i].anchor == anchor && definitions[i].type != type) {
+                definitions[i].type = type;
+                emit labelTypeChanged(mSymbols->name(label), line);
+            }
+        }
+        // The definition already holds a use of the name
+        mSymbols->release(label);
         return;
-    if (labelAtLine(line) != label)
+    }
+
+    // A line declares at most one label, so another label here is gone
+    if (anchor)
+        removeLabel(anchor->value(), line);
+
+    // Add this definition to our data structures. A label can be defined on
+    // more than one line; every definition is kept
+    LabelInfo newLabelInfo = {mLabelsByLine.insert(line, label), type};
+    LabelInfos& definitions = mLinesByLabel[label];
+    definitions.push_back(newLabelInfo);
+
+    const QString name = mSymbols->name(label);
+    emit labelAdded(name, line);
+
+    if (definitions.size() == 2) {
+        mDuplicateLabels.insert(label);
+        emit duplicateStateChanged(name, true);
+    }
+}
+
+void DocumentLabelIndex::removeLabel(SymbolId label, int line)
+{
+    const QString name = mSymbols->name(label);
+    qDebug() << "removing label:" << name << "at line:" << line;
+
+    LabelAnchors::Anchor* anchor = mLabelsByLine.find(line);
+    if (!anchor || anchor->value() != label)
         return;
 
-    // Remove the label from our data structures
-    mLinesByLabel.remove(label);
+    // Remove the definition from our data structures
+    const bool wasDuplicate = removeDefinition(anchor);
 
     qDebug() << "removed";
-    emit labelRemoved(label, line);
+    emit labelRemoved(name, line);
+
+    if (wasDuplicate)
+        emit duplicateStateChanged(name, false);
+
+    // Only now, so that listeners could still look the name up
+    mSymbols->release(label);
 }
 
-void DocumentLabelIndex::onTokensAdded(const TokenList& tokens, int line)
+bool DocumentLabelIndex::removeDefinition(LabelAnchors::Anchor* anchor)
 {
-    Q_UNUSED(tokens);
-    readLabelsFromLine(mTokenizer->tokensInLine(line), line);
+    // Returns true if this leaves the label with a single definition
+    QHash<SymbolId, LabelInfos>::iterator i = mLinesByLabel.find(anchor->value());
+    Q_ASSERT(i != mLinesByLabel.end());
+
+    LabelInfos& definitions = i.value();
+    for (int j = 0; j < definitions.size(); ++j) {
+        if (definitions[j].anchor == anchor) {
+            definitions.remove(j);
+            break;
+        }
+    }
+    mLabelsByLine.remove(anchor);
+
+    if (definitions.isEmpty()) {
+        mLinesByLabel.erase(i);
+    } else if (definitions.size() == 1) {
+        mDuplicateLabels.remove(i.key());
+        return true;
+    }
+    return false;
 }
 
-void DocumentLabelIndex::onTokensRemoved(const TokenList& tokens, int line)
+const DocumentLabelIndex::LabelInfo* DocumentLabelIndex::firstDefinition(SymbolId label) const
 {
-    foreach (const Token& token, tokens) {
-        if (hasLabelAtLine(token.value, line)) {
-            removeLabel(token.value, line);
-        }
+    // The definition nearest the top of the document stands for the label
+    QHash<SymbolId, LabelInfos>::const_iterator i = mLinesByLabel.constFind(label);
+    if (i == mLinesByLabel.constEnd())
+        return NULL;
+
+    const LabelInfos& definitions = i.value();
+    const LabelInfo* first = &definitions.first();
+    for (int j = 1; j < definitions.size(); ++j) {
+        if (mLabelsByLine.lineOf(definitions[j].anchor) < mLabelsByLine.lineOf(first->anchor))
+            first = &definitions[j];
+    }
+    return first;
+}
+
+void DocumentLabelIndex::onLineChanged(int line, const TokenLineDiff& diff)
+{
+    // Any edit can change which labels the line uses
+    const TokenLine& tokensInLine = mTokenizer->tokensInLine(line);
+    readReferencesFromLine(tokensInLine, line);
+
+    // A line declares a label through its first token, and the second token
+    // decides the label's type, so edits further along the line don't matter
+    bool touchesDeclaration = false;
+    foreach (const TokenEdit& edit, diff) {
+        if (edit.oldIndex <= 1 || edit.newIndex <= 1)
+            touchesDeclaration = true;
+    }
+    if (!touchesDeclaration)
+        return;
+
+    const SymbolId oldLabel = symbolAtLine(line);
+    if (oldLabel != SymbolTable::NO_SYMBOL) {
+        const bool stillDeclared = !tokensInLine.isEmpty() &&
+                tokensInLine.typeAt(0) == Token::Label &&
+                mSymbols->find(tokensInLine.valueAt(0).toString()) == oldLabel;
+        if (!stillDeclared)
+            removeLabel(oldLabel, line);
+    }
+    readLabelsFromLine(tokensInLine, line);
+}
+
+void DocumentLabelIndex::onLinesParsed(int firstLine, int count)
+{
+    // Lines tokenized in the background arrive after they were added
+    for (int line = firstLine; line < firstLine + count; ++line) {
+        readLabelsFromLine(mTokenizer->tokensInLine(line), line);
+        readReferencesFromLine(mTokenizer->tokensInLine(line), line);
     }
+    emit linesParsed(firstLine, count);
 }
 
-void DocumentLabelIndex::onLineAdded(int afterLine)
+void DocumentLabelIndex::onLinesAdded(int afterLine, int count)
 {
     // Shift the line numbers of all the labels that come after afterLine
-    qDebug() << "Shifting labels forward after line" << afterLine;
-    const int lastLine = tokenizer()->numLines() - 1;
-    for (int i = lastLine; i > afterLine; --i) {
-        if (hasLabelAtLine(i)) {
-            // Shift the label one line up
-            QString label = labelAtLine(i);
-            mLinesByLabel[label].lineNumber += 1;
-        }
+    qDebug() << "Shifting labels forward by" << count << "after line" << afterLine;
+    mLabelsByLine.shift(afterLine + 1, count);
+    mReferencesByLine.shift(afterLine + 1, count);
+
+    // Then pick up the labels on the new lines
+    for (int line = afterLine + 1; line <= afterLine + count; ++line) {
+        readLabelsFromLine(mTokenizer->tokensInLine(line), line);
+        readReferencesFromLine(mTokenizer->tokensInLine(line), line);
     }
-    emit lineAdded(afterLine);
+    emit linesAdded(afterLine, count);
 }
 
-void DocumentLabelIndex::onLineRemoved(int lineNumber)
+void DocumentLabelIndex::onLinesRemoved(int firstLine, int count)
 {
-    // The last line that we used to have should be one after the actual last line
-    const int lastLine = tokenizer()->numLines();
-    qDebug() << "Shifting labels backward after line" << lineNumber - 1 << "until line" << lastLine;
-    for (int i = lineNumber + 1; i <= lastLine; ++i) {
-        if (hasLabelAtLine(i)) {
-            // Shift the label one line down
-            QString label = labelAtLine(i);
-            qDebug() << "shifting" << label << "down from line" << i << "to line" << i - 1;
-            mLinesByLabel[label].lineNumber -= 1;
-        }
+    // Drop the labels on the removed lines and shift the ones after them back
+    qDebug() << "Shifting labels backward by" << count << "from line" << firstLine + count;
+    const int endLine = firstLine + count;
+    QList<QPair<SymbolId, int> > removedLabels;
+    QList<SymbolId> noLongerDuplicateLabels;
+    LabelAnchors::Anchor* anchor = mLabelsByLine.lowerBound(firstLine);
+    while (anchor && mLabelsByLine.lineOf(anchor) < endLine) {
+        LabelAnchors::Anchor* nextAnchor = mLabelsByLine.next(anchor);
+        const SymbolId label = anchor->value();
+        removedLabels.push_back(qMakePair(label, mLabelsByLine.lineOf(anchor)));
+        if (removeDefinition(anchor))
+            noLongerDuplicateLabels.push_back(label);
+        anchor = nextAnchor;
+    }
+    mLabelsByLine.shift(endLine, -count);
+
+    // The uses on the removed lines go too
+    QSet<SymbolId> changedLabels;
+    SymbolList releasedLabels;
+    ReferenceAnchors::Anchor* reference = mReferencesByLine.lowerBound(firstLine);
+    while (reference && mReferencesByLine.lineOf(reference) < endLine) {
+        ReferenceAnchors::Anchor* nextReference = mReferencesByLine.next(reference);
+        removeReferences(reference, changedLabels, releasedLabels);
+        reference = nextReference;
+    }
+    mReferencesByLine.shift(endLine, -count);
+
+    for (int j = 0; j < removedLabels.size(); ++j) {
+        emit labelRemoved(mSymbols->name(removedLabels[j].first), removedLabels[j].second);
+    }
+    foreach (SymbolId label, noLongerDuplicateLabels) {
+        if (!isDuplicateLabel(label))
+            emit duplicateStateChanged(mSymbols->name(label), false);
+    }
+    foreach (SymbolId label, changedLabels) {
+        emit referencesChanged(mSymbols->name(label));
+    }
+
+    for (int j = 0; j < removedLabels.size(); ++j) {
+        releasedLabels.push_back(removedLabels[j].first);
     }
-    emit lineRemoved(lineNumber);
+    releaseSymbols(releasedLabels);
+    emit linesRemoved(firstLine, count);
 }
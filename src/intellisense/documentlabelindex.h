@@ -26,8 +26,9 @@
 #include "intellisense_global.h"
 
 #include <QObject>
-#include <QMap>
+#include <QHash>
 #include <QSet>
+#include <QStringList>
 #include <QVector>
 
 QT_BEGIN_NAMESPACE
@@ -35,6 +36,8 @@ class QTextDocument;
 QT_END_NAMESPACE
 
 #include "documenttokenizer.h"
+#include "lineanchormap.h"
+#include "symboltable.h"
 
 class INTELLISENSE_EXPORT DocumentLabelIndex : public QObject
 {
@@ -54,10 +57,28 @@ public:
     bool hasLabelAtLine(const QString& label, int line) const;
     bool isFunctionLabel(const QString& label) const;
     bool isVariableLabel(const QString& label) const;
+    bool isDuplicateLabel(const QString& label) const;
     int lineNumberOfLabel(const QString& label) const;
+    QList<int> definitionsOfLabel(const QString& label) const;
+    QList<QString> duplicateLabels() const;
     QString labelAtLine(int line) const;
     QList<QString> labels() const;
 
+    QList<int> referencesOfLabel(const QString& label) const;
+    int numReferences(const QString& label) const;
+
+    // The same queries by interned name, for callers that already hold ids
+    bool hasLabel(SymbolId label) const;
+    bool hasLabelAtLine(SymbolId label, int line) const;
+    bool isFunctionLabel(SymbolId label) const;
+    bool isVariableLabel(SymbolId label) const;
+    bool isDuplicateLabel(SymbolId label) const;
+    int lineNumberOfLabel(SymbolId label) const;
+    QList<int> definitionsOfLabel(SymbolId label) const;
+    SymbolId symbolAtLine(int line) const;
+    QList<SymbolId> labelSymbols() const;
+    int numReferences(SymbolId label) const;
+
     enum LabelType {
         FunctionLabel,
         VariableLabel
@@ -67,31 +88,65 @@ signals:
     void documentChanged(QTextDocument* newDocument);
     void labelAdded(const QString& label, int line);
     void labelRemoved(const QString& label, int line);
-    void lineAdded(int afterLine);
-    void lineRemoved(int lineNumber);
+    void labelTypeChanged(const QString& label, int line);
+    void duplicateStateChanged(const QString& label, bool isDuplicate);
+    void linesAdded(int afterLine, int count);
+    void linesRemoved(int firstLine, int count);
+    void linesParsed(int firstLine, int count);
+    void referencesChanged(const QString& label);
 
 protected:
     void reset();
     void readFromTokenizer();
-    void readLabelsFromLine(const TokenList& tokensInLine, int line);
-    void addLabel(const QString& label, int line, LabelType type = VariableLabel);
-    void removeLabel(const QString& label, int line);
+    void readLabelsFromLine(const TokenLine& tokensInLine, int line);
+    void readReferencesFromLine(const TokenLine& tokensInLine, int line);
+    void addLabel(SymbolId label, int line, LabelType type = VariableLabel);
+    void removeLabel(SymbolId label, int line);
 
 private slots:
-    void onTokensAdded(const TokenList& tokens, int line);
-    void onTokensRemoved(const TokenList& tokens, int line);
-    void onLineAdded(int afterLine);
-    void onLineRemoved(int lineNumber);
+    void onLineChanged(int line, const TokenLineDiff& diff);
+    void onLinesParsed(int firstLine, int count);
+    void onLinesAdded(int afterLine, int count);
+    void onLinesRemoved(int firstLine, int count);
 
 private:
     DocumentTokenizer* mTokenizer;
 
+    SymbolTable* mSymbols;
+
+    // Labels are kept by SymbolId throughout; names are only looked up at the
+    // public interface and when signals go out
+    typedef LineAnchorMap<SymbolId> LabelAnchors;
+
     struct LabelInfo {
-        int lineNumber;
+        LabelAnchors::Anchor* anchor;
         LabelType type;
     };
 
-    QMap<QString, LabelInfo> mLinesByLabel;
+    // Every definition of a label, in the order they were found. Almost always
+    // just one
+    typedef QVector<LabelInfo> LabelInfos;
+
+    // Both directions are kept in step: every definition in mLinesByLabel has
+    // its anchor in mLabelsByLine and vice versa. Anchors move with inserted and
+    // removed lines, so label line numbers never have to be rewritten.
+    QHash<SymbolId, LabelInfos> mLinesByLabel;
+    LabelAnchors mLabelsByLine;
+    QSet<SymbolId> mDuplicateLabels;
+
+    bool removeDefinition(LabelAnchors::Anchor* anchor);
+    const LabelInfo* firstDefinition(SymbolId label) const;
+
+    typedef QVector<SymbolId> SymbolList;
+    typedef LineAnchorMap<SymbolList> ReferenceAnchors;
+
+    // The lines that use labels as operands, each anchored with the labels it
+    // uses, and for every label the anchors of the lines that use it
+    ReferenceAnchors mReferencesByLine;
+    QHash<SymbolId, QSet<ReferenceAnchors::Anchor*> > mReferenceLinesByLabel;
+
+    void removeReferences(ReferenceAnchors::Anchor* anchor, QSet<SymbolId>& changedLabels, SymbolList& releasedLabels);
+    void releaseSymbols(const SymbolList& labels);
 };
 
 #endif // DOCUMENTLABELINDEX_H
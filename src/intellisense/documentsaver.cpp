@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "documentsaver.h"
+
+#include <QTextDocument>
+
+#include "savethread.h"
+
+DocumentSaver::DocumentSaver(QTextDocument* document, QObject* parent) :
+    QObject(parent),
+    mDocument(document),
+    mThread(NULL),
+    mSavedRevision(0)
+{
+}
+
+DocumentSaver::~DocumentSaver()
+{
+    if (mThread) {
+        mThread->disconnect(this);
+        mThread->wait();
+        delete mThread;
+        mThread = NULL;
+    }
+}
+
+void DocumentSaver::save(const QString& fileName)
+{
+    if (mThread)
+        mQueuedSave = fileName;
+    else
+        start(fileName);
+}
+
+bool DocumentSaver::isSaving() const
+{
+    return mThread != NULL;
+}
+
+bool DocumentSaver::wait()
+{
+    bool succeeded = true;
+
+    // A queued save starts as the one before it finishes, so keep going
+    // until there are none left
+    while (mThread) {
+        mThread->wait();
+        succeeded = mThread->succeeded();
+        onThreadFinished();
+    }
+
+    return succeeded;
+}
+
+QString DocumentSaver::fileName() const
+{
+    return mFileName;
+}
+
+QString DocumentSaver::errorString() const
+{
+    return mError;
+}
+
+void DocumentSaver::start(const QString& fileName)
+{
+    // The thread gets its own copy of the text, so typing carries on while
+    // it is written without changing what gets saved
+    mSavedRevision = mDocument->revision();
+    mThread = new SaveThread(fileName, mDocument->toPlainText(), this);
+    connect(mThread, SIGNAL(finished()), this, SLOT(onThreadFinished()));
+    mThread->start();
+}
+
+void DocumentSaver::onThreadFinished()
+{
+    // wait() may already have dealt with this one
+    if (!mThread || !mThread->isFinished())
+        return;
+
+    SaveThread* thread = mThread;
+    mThread = NULL;
+    thread->deleteLater();
+
+    const bool succeeded = thread->succeeded();
+    mFileName = thread->fileName();
+    mError = thread->errorString();
+
+    // Anything typed since the snapshot still needs saving
+    if (succeeded && mDocument->revision() == mSavedRevision)
+        mDocument->setModified(false);
+
+    // Report first, so the editor has caught up with this save before the
+    // file changes under it again
+    emit saveFinished(succeeded);
+
+    if (!mQueuedSave.isEmpty()) {
+        const QString fileName = mQueuedSave;
+        mQueuedSave.clear();
+        save(fileName);
+    }
+}
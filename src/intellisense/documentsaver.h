@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DOCUMENTSAVER_H
+#define DOCUMENTSAVER_H
+
+#include <QObject>
+#include <QString>
+
+#include "intellisense_global.h"
+
+QT_BEGIN_NAMESPACE
+class QTextDocument;
+QT_END_NAMESPACE
+
+class SaveThread;
+
+// Saves a document on a SaveThread, so a large file doesn't hold up typing.
+//
+// save() takes a snapshot of the text there and then; edits made while it is
+// being written don't change what gets saved, and leave the document modified.
+// One save writes at a time. A save asked for while another is running takes
+// its snapshot once that one is done; only the last one asked for is kept.
+class INTELLISENSE_EXPORT DocumentSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DocumentSaver(QTextDocument* document, QObject* parent = 0);
+
+    // Lets a save already writing land, but reports nothing and drops any
+    // queued save
+    ~DocumentSaver();
+
+    void save(const QString& fileName);
+    bool isSaving() const;
+
+    // Blocks until every running and queued save is done, reporting each one
+    // through saveFinished(). Returns whether the last of them succeeded
+    bool wait();
+
+    // The file the last finished save went to, and why it failed if it did
+    QString fileName() const;
+    QString errorString() const;
+
+signals:
+    void saveFinished(bool succeeded);
+
+private slots:
+    void onThreadFinished();
+
+private:
+    QTextDocument* mDocument;
+    SaveThread* mThread;
+    int mSavedRevision;
+    QString mQueuedSave;
+    QString mFileName;
+    QString mError;
+
+    void start(const QString& fileName);
+};
+
+#endif // DOCUMENTSAVER_H
@@ -28,15 +28,31 @@
 #include <QTextBlock>
 #include <QTextDocument>
 
+#include "linelexer.h"
+#include "tokenblockdata.h"
+#include "tokenizerthread.h"
+
 DocumentTokenizer::DocumentTokenizer(QTextDocument* doc) :
     mDoc(NULL),
     mCursorPos(0),
     mReceivedLongDocumentChange(false),
-    mAwaitingLineCountChange(false)
+    mNumTokens(0),
+    mGeneration(0),
+    mBackgroundParsingEnabled(false)
 {
+    qRegisterMetaType<QVector<TokenLine> >("QVector<TokenLine>");
+
+    mJob.id = 0;
+    mJob.firstLine = 0;
+
     setDocument(doc);
 }
 
+DocumentTokenizer::~DocumentTokenizer()
+{
+    cancelBackgroundParse();
+}
+
 QTextDocument* DocumentTokenizer::document()
 {
     return mDoc;
@@ -51,7 +67,6 @@ void DocumentTokenizer::setDocument(QTextDocument* doc)
                    SLOT(onDocumentContentsChanged(int, int, int)));
         disconnect(mDoc, SIGNAL(cursorPositionChanged(QTextCursor)), this,
                    SLOT(onCursorPositionChanged(QTextCursor)));
-        disconnect(mDoc, SIGNAL(blockCountChanged(int)), this, SLOT(onLineCountChange(int)));
     }
 
     mDoc = doc;
@@ -64,7 +79,11 @@ void DocumentTokenizer::setDocument(QTextDocument* doc)
                 SLOT(onDocumentContentsChanged(int, int, int)));
         connect(mDoc, SIGNAL(cursorPositionChanged(QTextCursor)), this,
                 SLOT(onCursorPositionChanged(QTextCursor)));
-        connect(mDoc, SIGNAL(blockCountChanged(int)), this, SLOT(onLineCountChange(int)));
+
+        // QTextDocument only emits contentsChange(int, int, int) once it has a
+        // layout. Without it every edit would fall back to reparsing the whole
+        // document in onDocumentContentsChanged()
+        mDoc->documentLayout();
     }
 
     reset();
@@ -73,31 +92,56 @@ void DocumentTokenizer::setDocument(QTextDocument* doc)
     emit documentChanged(mDoc);
 }
 
-TokenList DocumentTokenizer::tokens()
+bool DocumentTokenizer::isBackgroundParsingEnabled() const
 {
-    TokenList ret;
+    return mBackgroundParsingEnabled;
+}
 
-    // For each line
-    foreach (const TokenList& tokensInLine, mTokensByLine) {
-        // For each token in the line
-        foreach(const Token& token, tokensInLine) {
-            ret.push_back(token);
-        }
+void DocumentTokenizer::setBackgroundParsingEnabled(bool enabled)
+{
+    mBackgroundParsingEnabled = enabled;
+}
+
+bool DocumentTokenizer::isParsing() const
+{
+    return !mJob.thread.isNull();
+}
+
+DocumentTokenizer::TokenRange DocumentTokenizer::tokensInLines(int firstLine, int count) const
+{
+    Q_ASSERT(firstLine >= 0 && count >= 0);
+
+    const int endLine = qMin(firstLine + count, numLines());
+    return TokenRange(&mTokensByLine, qMin(firstLine, endLine), endLine);
+}
+
+TokenList DocumentTokenizer::tokens() const
+{
+    // Copies every token; prefer iterating with begin() and end()
+    TokenList ret;
+    ret.reserve(mNumTokens);
+    for (const_iterator i = begin(); i != end(); ++i) {
+        ret.append(i.token());
     }
     return ret;
 }
 
-TokenList DocumentTokenizer::tokensInLine(int lineNumber) const
+const TokenLine& DocumentTokenizer::tokensInLine(int lineNumber) const
 {
     Q_ASSERT(lineNumber >= 0);
     Q_ASSERT(lineNumber == 0 || lineNumber < numLines());
 
-    return mTokensByLine[lineNumber];
+    // An empty document still has one (empty) line
+    static const TokenLine EMPTY_LINE;
+    if (lineNumber >= numLines())
+        return EMPTY_LINE;
+
+    return mTokensByLine.at(lineNumber);
 }
 
 int DocumentTokenizer::numTokens() const
 {
-    return mTokens.size();
+    return mNumTokens;
 }
 
 int DocumentTokenizer::numLines() const
@@ -105,208 +149,261 @@ int DocumentTokenizer::numLines() const
     return mTokensByLine.size();
 }
 
-void DocumentTokenizer::addLine(int afterLine)
+int DocumentTokenizer::generation() const
 {
-    qDebug() << "adding line after line" << afterLine;
-    bool isAddingLineToEndOfDoc = afterLine == numLines() - 1;
-
-    // Make sure we have at least afterLine number of lines
-    while (numLines() <= afterLine) {
-        mTokensByLine.push_back(TokenList());
-    }
-
-    TokenLineMap::iterator whereToInsertLine = mTokensByLine.begin() + afterLine + 1;
-    mTokensByLine.insert(whereToInsertLine, TokenList());
-
-    // If the new line that we added was added to the end of the document, add
-    // a newline token to the second to last line.
-    // Otherwise add a newline token to the newly added line
-    Token newline = {"\n", Token::Newline};
-    TokenList added = {newline};
-    const int whereToAddNewlineToken = (isAddingLineToEndOfDoc) ? afterLine : afterLine + 1;
-    if (whereToAddNewlineToken >= 0) {
-        mTokensByLine[whereToAddNewlineToken].push_back(newline);
-        emit tokensAdded(added, whereToAddNewlineToken);
-    }
-
-    emit lineAdded(afterLine);
+    return mGeneration;
 }
 
-void DocumentTokenizer::removeLine(int lineNumber)
+QVector<LineRangeChange> DocumentTokenizer::changesSince(int generation, bool* ok) const
 {
-    Q_ASSERT(lineNumber >= 0);
-    Q_ASSERT(lineNumber < numLines());
-
-    qDebug() << "removing line" << lineNumber;
+    // The journal holds consecutive generations, ending at the current one
+    const int oldestKnown = mJournal.isEmpty() ? mGeneration : mJournal.first().generation - 1;
+    const bool known = generation >= oldestKnown && generation <= mGeneration;
+    if (ok)
+        *ok = known;
 
-    bool isRemovingLastLine = (lineNumber == numLines() - 1);
-    TokenList removedTokens = mTokensByLine[lineNumber];
+    // A consumer that fell too far behind has to start over from the tokens
+    if (!known)
+        return QVector<LineRangeChange>();
 
-    mTokensByLine.erase(mTokensByLine.begin() + lineNumber);
-    emit tokensRemoved(removedTokens, lineNumber);
-
-    // Remove the newline token from the previous line if the previous line is now the last line
-    if (isRemovingLastLine) {
-        emit tokensRemoved(removedTokens, lineNumber);
-        removedTokens.clear();
-        removedTokens.push_back({"\n", Token::Newline});
-        mTokensByLine[lineNumber - 1].pop_back();
-        emit tokensRemoved(removedTokens, lineNumber - 1);
-    }
-    emit lineRemoved(lineNumber);
+    return mJournal.mid(mJournal.size() - (mGeneration - generation));
 }
 
-void DocumentTokenizer::setLine(const TokenList& tokens, int line)
+void DocumentTokenizer::replaceLines(int firstLine, int oldCount, int newCount)
 {
-    Q_ASSERT(line >= 0);
-
-    qDebug() << "setting line" << line;
+    Q_ASSERT(mDoc);
+    Q_ASSERT(firstLine >= 0);
+    Q_ASSERT(oldCount >= 0 && firstLine + oldCount <= numLines());
+    Q_ASSERT(newCount >= 0 && firstLine + newCount <= mDoc->blockCount());
 
-    // Add new lines until we have at least line + 1 of them
-    while (line >= numLines()) {
-        addLine(numLines() - 1);
+    if (mBackgroundParsingEnabled && newCount >= BACKGROUND_PARSE_MIN_LINES) {
+        replaceLinesInBackground(firstLine, oldCount, newCount);
+        return;
     }
 
-    // Set the tokens in that line to the TokenList passed in
-    TokenList oldTokens = mTokensByLine[line];
-    mTokensByLine[line] = tokens;
+    qDebug() << "replacing" << oldCount << "lines at line" << firstLine << "with" << newCount << "lines";
 
-    // If that line is the last line, remove the trailing newline token
-    if (line == numLines() - 1) {
-        mTokensByLine[line].pop_back();
+    // Tokenize the new lines, walking the blocks instead of looking each one up.
+    // A block the highlighter already lexed is not lexed again
+    QVector<TokenLine> newLines(newCount);
+    QTextBlock block = mDoc->findBlockByNumber(firstLine);
+    for (int i = 0; i < newCount; ++i, block = block.next()) {
+        newLines[i] = TokenBlockData::tokensOfBlock(block);
     }
 
-    // Report which tokens were added/removed
-    const TokenList& newTokens = tokens;
+    // The last line of the document never has a newline token
+    if (newCount > 0 && firstLine + newCount == mDoc->blockCount())
+        newLines[newCount - 1].removeTrailingNewline();
+
+    // Work out which tokens were removed and added. Lines that exist both before
+    // and after the edit are diffed token by token; all other lines are removed
+    // or added wholesale.
+    const int numPairedLines = qMin(oldCount, newCount);
+    QVector<TokenLineDiff> diffs(numPairedLines);
+    QVector<TokenList> removedTokens(oldCount);
+    QVector<TokenList> addedTokens(newCount);
+    for (int i = 0; i < numPairedLines; ++i) {
+        const TokenLine& oldLine = mTokensByLine[firstLine + i];
+        diffs[i] = TokenLine::diff(oldLine, newLines[i]);
+        foreach (const TokenEdit& edit, diffs[i]) {
+            for (int j = 0; j < edit.oldCount; ++j) {
+                removedTokens[i].push_back(oldLine.tokenAt(edit.oldIndex + j));
+            }
+            for (int j = 0; j < edit.newCount; ++j) {
+                addedTokens[i].push_back(newLines[i].tokenAt(edit.newIndex + j));
+            }
+        }
+    }
+    for (int i = numPairedLines; i < oldCount; ++i) {
+        removedTokens[i] = mTokensByLine[firstLine + i].toList();
+    }
+    for (int i = numPairedLines; i < newCount; ++i) {
+        addedTokens[i] = newLines[i].toList();
+    }
 
-    TokenList removedTokens;
-    foreach (const Token& token, oldTokens) {
-        if (!newTokens.contains(token))
-            removedTokens.push_back(token);
+    // Report removals first, while line numbers still refer to the old lines
+    for (int i = 0; i < oldCount; ++i) {
+        if (!removedTokens[i].isEmpty())
+            emit tokensRemoved(removedTokens[i], firstLine + i);
     }
 
-    TokenList addedTokens;
-    foreach (const Token& token, newTokens) {
-        if (!oldTokens.contains(token))
-            addedTokens.push_back(token);
+    // Lines still waiting on the background parse may move
+    if (isParsing()) {
+        LineEdit edit = {firstLine, oldCount, newCount};
+        mJob.edits.push_back(edit);
     }
 
-    if (removedTokens.size() > 0) {
-        qDebug() << "Removed tokens:" << removedTokens;
-        emit tokensRemoved(removedTokens, line);
-    } else {
-        qDebug() << "None removed";
+    // Splice the line table once
+    if (newCount > oldCount) {
+        addLines(firstLine + oldCount, newCount - oldCount);
+    } else if (newCount < oldCount) {
+        removeLines(firstLine + newCount, oldCount - newCount);
+    }
+    for (int i = 0; i < newCount; ++i) {
+        setLine(firstLine + i, newLines[i]);
+    }
+    recordChange(firstLine, oldCount, newCount);
+
+    if (newCount > oldCount)
+        emit linesAdded(firstLine + oldCount - 1, newCount - oldCount);
+    else if (newCount < oldCount)
+        emit linesRemoved(firstLine + newCount, oldCount - newCount);
+
+    // The paired lines keep their line numbers, so their exact edits can be
+    // reported once the table holds the new tokens
+    for (int i = 0; i < numPairedLines; ++i) {
+        if (!diffs[i].isEmpty())
+            emit lineChanged(firstLine + i, diffs[i]);
     }
 
-    if (addedTokens.size() > 0) {
-        qDebug() << "Added tokens:" << addedTokens;
-        emit tokensAdded(addedTokens, line);
-    } else {
-        qDebug() << "None added";
+    // Then report additions against the new line numbers
+    for (int i = 0; i < newCount; ++i) {
+        if (!addedTokens[i].isEmpty())
+            emit tokensAdded(addedTokens[i], firstLine + i);
     }
 }
 
-void DocumentTokenizer::reset()
+void DocumentTokenizer::replaceLinesInBackground(int firstLine, int oldCount, int newCount)
 {
-    TokenLineMap oldTokens = mTokensByLine;
-    mTokensByLine.clear();
-    int line = 0;
-    foreach (const TokenList& tokens, oldTokens) {
-        emit tokensRemoved(tokens, line);
-        line++;
+    // Only one range is tokenized in the background at a time. If another big
+    // edit comes in before it is done, start over on the whole document
+    if (isParsing()) {
+        cancelBackgroundParse();
+        firstLine = 0;
+        oldCount = numLines();
+        newCount = mDoc->blockCount();
     }
-    mReceivedLongDocumentChange = false;
-    mAwaitingLineCountChange = false;
-}
 
-void DocumentTokenizer::parse()
-{
-    if (mDoc) {
-        int beginPos = 0;
-        int endPos = mDoc->characterCount();
-        parse(beginPos, endPos);
+    qDebug() << "replacing" << oldCount << "lines at line" << firstLine << "with" << newCount <<
+                "lines in the background";
+
+    // The old lines go away right now
+    for (int i = 0; i < oldCount; ++i) {
+        const TokenLine& oldLine = mTokensByLine[firstLine + i];
+        if (!oldLine.isEmpty())
+            emit tokensRemoved(oldLine.toList(), firstLine + i);
     }
+    removeLines(firstLine, oldCount);
+    if (oldCount > 0)
+        emit linesRemoved(firstLine, oldCount);
+
+    // The new lines stay empty until their tokens come back from the thread
+    addLines(firstLine, newCount);
+    recordChange(firstLine, oldCount, newCount);
+    emit linesAdded(firstLine - 1, newCount);
+
+    // Snapshot the text of the new lines. Copying it out is far cheaper than
+    // lexing it, so this is all the GUI thread waits for
+    const QTextBlock lastBlock = mDoc->findBlockByNumber(firstLine + newCount - 1);
+    QTextCursor cursor(mDoc);
+    cursor.setPosition(mDoc->findBlockByNumber(firstLine).position());
+    cursor.setPosition(lastBlock.position() + lastBlock.length() - 1, QTextCursor::KeepAnchor);
+
+    mJob.id++;
+    mJob.firstLine = firstLine;
+    mJob.edits.clear();
+    mJob.thread = new TokenizerThread(mJob.id, cursor.selectedText(), this);
+    connect(mJob.thread, SIGNAL(linesTokenized(int,int,QVector<TokenLine>)), this,
+            SLOT(onLinesTokenized(int,int,QVector<TokenLine>)));
+    connect(mJob.thread, SIGNAL(finished()), this, SLOT(onBackgroundParseFinished()));
+    mJob.thread->start(QThread::LowPriority);
 }
 
-void DocumentTokenizer::parse(int beginPos, int endPos)
+void DocumentTokenizer::cancelBackgroundParse()
 {
-    if (mDoc) {
-        qDebug() << "parsing from position" << beginPos << "to" << endPos;
+    if (!isParsing())
+        return;
 
-        int beginLine = getLineNumberOfPosition(beginPos);
-        int endLine = getLineNumberOfPosition(endPos);
-        parseLines(beginLine, endLine);
-    }
+    qDebug() << "cancelling background parse" << mJob.id;
+
+    // Lines of the job that were not delivered yet are left empty
+    TokenizerThread* thread = mJob.thread;
+    disconnect(thread, 0, this, 0);
+    thread->cancel();
+    thread->wait();
+    delete thread;
+
+    mJob.thread = NULL;
+    mJob.edits.clear();
 }
 
-void DocumentTokenizer::parseLines(int beginLine, int endLine)
+void DocumentTokenizer::setLine(int lineNumber, const TokenLine& tokens)
 {
-    qDebug() << "parsing lines" << beginLine << "to" << endLine;
-    for (int i = beginLine; i <= endLine; ++i) {
-        parseLine(i);
-    }
+    TokenLine& line = mTokensByLine[lineNumber];
+    mNumTokens += tokens.size() - line.size();
+    line = tokens;
 }
 
-void DocumentTokenizer::parseLine(int lineNumber)
+void DocumentTokenizer::addLines(int lineNumber, int count)
 {
-    QString lineText = mDoc->findBlockByNumber(lineNumber).text();
-    TokenList tokensInLine = parseLineText(lineText);
-    setLine(tokensInLine, lineNumber);
+    // New lines start out empty
+    mTokensByLine.insert(lineNumber, count, TokenLine());
 }
 
-TokenList DocumentTokenizer::parseLineText(const QString& line)
+void DocumentTokenizer::removeLines(int firstLine, int count)
 {
-    TokenList tokensInLine;
-
-    // Watch out for comments!
-    int indexOfComment = Token::REGEX[Token::Comment].indexIn(line);
-    if (indexOfComment >= 0)
-    {
-        qDebug() << "comment found at index" << indexOfComment;
+    for (int i = 0; i < count; ++i) {
+        mNumTokens -= mTokensByLine.at(firstLine + i).size();
+    }
+    mTokensByLine.remove(firstLine, count);
+}
 
-        // Parse the part of the line that comes before the comment
-        QString beginningOfLine = line.left(indexOfComment);
-        qDebug() << "parsing" << beginningOfLine;
-        tokensInLine = parseLineText(beginningOfLine);
+void DocumentTokenizer::recordChange(int firstLine, int oldCount, int newCount)
+{
+    // Trim in batches so that recording stays amortized O(1)
+    if (mJournal.size() >= 2 * JOURNAL_CAPACITY)
+        mJournal.remove(0, mJournal.size() - JOURNAL_CAPACITY);
 
-        // Remove newline token from that parsed list
-        tokensInLine.pop_back();
+    LineRangeChange change = {++mGeneration, firstLine, oldCount, newCount};
+    mJournal.push_back(change);
+}
 
-        // Add the comment token
-        QString commentString = line.right(line.length() - indexOfComment);
-        tokensInLine.push_back(parseWord(commentString));
-    }
-    else
-    {
-        // If not a comment, split the line into words and parse each word
-        QStringList words = line.split(Token::REGEX[Token::Whitespace], QString::SkipEmptyParts);
-        qDebug() << "Split line into words: " << words;
-        foreach (const QString& word, words) {
-            tokensInLine.push_back(parseWord(word));
-        }
+int DocumentTokenizer::currentLineOfJobLine(int jobLine) const
+{
+    // Replay the edits made since the snapshot. Returns -1 if the line has been
+    // replaced, in which case it was already tokenized from the document
+    int line = mJob.firstLine + jobLine;
+    foreach (const LineEdit& edit, mJob.edits) {
+        if (line >= edit.firstLine + edit.oldCount)
+            line += edit.newCount - edit.oldCount;
+        else if (line >= edit.firstLine)
+            return -1;
     }
+    return line;
+}
 
-    // Add a newline token to the end of every line
-    Token newline = {"\n", Token::Newline};
-    tokensInLine.push_back(newline);
+void DocumentTokenizer::reset()
+{
+    cancelBackgroundParse();
 
-    return tokensInLine;
+    TokenLineMap oldTokens = mTokensByLine;
+    mTokensByLine.clear();
+    mNumTokens = 0;
+    recordChange(0, oldTokens.size(), 0);
+    for (int line = 0; line < oldTokens.size(); ++line) {
+        emit tokensRemoved(oldTokens.at(line).toList(), line);
+    }
+    mReceivedLongDocumentChange = false;
 }
 
-Token DocumentTokenizer::parseWord(const QString& word)
+void DocumentTokenizer::parse()
 {
-    Token token;
-    token.value = word;
-
-    for (int i = 0; i < Token::NUM_TOKEN_TYPES - 1; ++i) {
-        if (Token::REGEX[i].exactMatch(word)) {
-            token.type = static_cast<Token::TokenType>(i);
-            return token;
-        }
+    if (mDoc) {
+        qDebug() << "parsing whole document";
+        replaceLines(0, numLines(), mDoc->blockCount());
     }
-    token.type = Token::Unrecognized;
+}
 
-    return token;
+void DocumentTokenizer::parseLines(int beginLine, int endLine)
+{
+    qDebug() << "parsing lines" << beginLine << "to" << endLine;
+    const int count = endLine - beginLine + 1;
+    replaceLines(beginLine, count, count);
+}
+
+TokenLine DocumentTokenizer::parseLineText(const QString& line)
+{
+    return LineLexer::tokenize(line);
 }
 
 void DocumentTokenizer::onDocumentContentsChanged()
@@ -328,35 +425,19 @@ void DocumentTokenizer::onDocumentContentsChanged(int position, int charsRemoved
     const int endPosition = position + charsAdded;
     mCursorPos = endPosition;
 
+    // By now the document already holds the new text. The added text spans
+    // blocks firstLine..lastLine, and the difference in line count tells us how
+    // many of our old lines those blocks replace.
+    const int firstLine = getLineNumberOfPosition(position);
+    const int lastLine = getLineNumberOfPosition(endPosition);
+    const int newCount = lastLine - firstLine + 1;
+    const int oldCount = newCount - (mDoc->blockCount() - numLines());
 
-    const int startLineNumber = (mDoc->characterAt(position) == '\n') ?
-                getLineNumberOfPosition(position - 1) : getLineNumberOfPosition(position);
-    qDebug() << "changed @ start line:" << startLineNumber;
-
-    if (charsAdded > 0) {
-        // First reparse the starting line
-        parseLine(startLineNumber);
-
-        QString docText = mDoc->toPlainText();
-        QStringRef addedText = docText.midRef(position, charsAdded);
-        qDebug() << "added text:" << addedText;
-
-        // If any new lines were added as a result of the new text, account for that
-        QVector<QStringRef> splitByNewline = addedText.split('\n');
-        const int numLinesAdded = splitByNewline.size() - 1;
-        qDebug() << numLinesAdded << "lines added";
-        int line = startLineNumber;
-        for (int i = 1; i <= numLinesAdded; ++i) {
-            addLine(line++);
-            parseLine(line);
-        }
-    }
-
-    else if (charsRemoved > 0) {
-        // First reparse the start line
-        parseLine(startLineNumber);
-        mAwaitingLineCountChange = true;
-        mAwaitingLineNumber = startLineNumber;
+    if (oldCount >= 1 && firstLine + oldCount <= numLines()) {
+        replaceLines(firstLine, oldCount, newCount);
+    } else {
+        // Our lines are out of step with the document; start over
+        parse();
     }
 
     mReceivedLongDocumentChange = true;
@@ -370,31 +451,74 @@ void DocumentTokenizer::onCursorPositionChanged(const QTextCursor& cursor)
         mCursorPos = cursor.position();
 }
 
-void DocumentTokenizer::onLineCountChange(int newLineCount)
+void DocumentTokenizer::onLinesTokenized(int jobId, int firstLine, const QVector<TokenLine>& lines)
 {
-    const int difference = newLineCount - numLines();
-    const int cursorPos = mCursorPos;
+    // Ignore chunks that were already on their way when their job was cancelled
+    if (jobId != mJob.id || !isParsing())
+        return;
+
+    qDebug() << "background parse delivered" << lines.size() << "lines from line" << firstLine;
+
+    int runStart = 0;
+    int runLength = 0;
+    QTextBlock block;
+    for (int i = 0; i < lines.size(); ++i) {
+        const int line = currentLineOfJobLine(firstLine + i);
+        if (line < 0)
+            continue;
+
+        // Report the lines in contiguous runs
+        if (runLength > 0 && line == runStart + runLength) {
+            ++runLength;
+            block = block.next();
+        } else {
+            if (runLength > 0) {
+                recordChange(runStart, runLength, runLength);
+                emit linesParsed(runStart, runLength);
+            }
+            runStart = line;
+            runLength = 1;
+            block = mDoc->findBlockByNumber(line);
+        }
 
-    qDebug() << "line count changed to:" << newLineCount;
-    qDebug() << "cursor pos:" << cursorPos;
+        // Leave the tokens on the block for the highlighter, which redraws the
+        // lines when they are reported as parsed
+        TokenBlockData::store(block, lines[i]);
 
-    if (mAwaitingLineCountChange && difference < 0) {
-        int numLinesToRemove = -difference;
-        for (int i = 0; i < numLinesToRemove; ++i) {
-            removeLine(mAwaitingLineNumber + 1);
-        }
+        TokenLine tokens = lines[i];
+        if (line == numLines() - 1)
+            tokens.removeTrailingNewline();
+        setLine(line, tokens);
+
+        if (!tokens.isEmpty())
+            emit tokensAdded(tokens.toList(), line);
+    }
+    if (runLength > 0) {
+        recordChange(runStart, runLength, runLength);
+        emit linesParsed(runStart, runLength);
     }
+}
 
-    mAwaitingLineCountChange = false;
+void DocumentTokenizer::onBackgroundParseFinished()
+{
+    if (sender() != mJob.thread.data())
+        return;
+
+    qDebug() << "background parse" << mJob.id << "finished";
+
+    mJob.thread->deleteLater();
+    mJob.thread = NULL;
+    mJob.edits.clear();
+
+    emit parsingFinished();
 }
 
 int DocumentTokenizer::getLineNumberOfPosition(int pos) const
 {
-    QTextCursor cursor(mDoc);
+    Q_ASSERT(mDoc);
     if (pos >= mDoc->characterCount())
         pos = mDoc->characterCount() - 1;
-    cursor.setPosition(pos);
-    return cursor.block().blockNumber();
+    return mDoc->findBlock(pos).blockNumber();
 }
 
 int DocumentTokenizer::getStartPosOfLine(int line) const
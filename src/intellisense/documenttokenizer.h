@@ -26,73 +26,337 @@
 #include <QObject>
 #include <QList>
 #include <QMap>
+#include <QPointer>
 #include <QTextCursor>
 
+#include <iterator>
+
+#include "gapbuffer.h"
 #include "intellisense_global.h"
 #include "token.h"
+#include "tokenline.h"
 
 QT_BEGIN_NAMESPACE
 class QTextDocument;
 QT_END_NAMESPACE
 
-typedef QList<Token> TokenList;
-typedef QVector<TokenList> TokenLineMap;
+class TokenizerThread;
+
+typedef GapBuffer<TokenLine> TokenLineMap;
+
+// An entry in the DocumentTokenizer's change journal: the oldCount lines
+// starting at firstLine were replaced by newCount lines, taking the tokenizer to
+// the given generation. Line numbers are the ones current at the time.
+struct LineRangeChange
+{
+    int generation;
+    int firstLine;
+    int oldCount;
+    int newCount;
+};
+
+Q_DECLARE_TYPEINFO(LineRangeChange, Q_PRIMITIVE_TYPE);
 
 class INTELLISENSE_EXPORT DocumentTokenizer : public QObject
 {
     Q_OBJECT
 
 public:
+    // Edits that add at least this many lines are tokenized in the background
+    // when background parsing is enabled
+    static const int BACKGROUND_PARSE_MIN_LINES = 2000;
+
+    // The journal remembers at least this many of the latest changes
+    static const int JOURNAL_CAPACITY = 1024;
+
     explicit DocumentTokenizer(QTextDocument* doc = 0);
+    virtual ~DocumentTokenizer();
 
     QTextDocument* document();
     void setDocument(QTextDocument* doc);
 
-    TokenList tokens();
-    TokenList tokensInLine(int lineNumber) const;
+    bool isBackgroundParsingEnabled() const;
+    void setBackgroundParsingEnabled(bool enabled);
+    bool isParsing() const;
+
+    class const_iterator;
+    class TokenRange;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator constBegin() const;
+    const_iterator constEnd() const;
+    TokenRange tokensInLines(int firstLine, int count) const;
+
+    TokenList tokens() const;
+    const TokenLine& tokensInLine(int lineNumber) const;
     int numTokens() const;
     int numLines() const;
 
+    int generation() const;
+    QVector<LineRangeChange> changesSince(int generation, bool* ok = 0) const;
+
 signals:
     void documentChanged(QTextDocument* newDocument);
     void tokensAdded(const TokenList& tokens, int lineNumber);
     void tokensRemoved(const TokenList& tokens, int lineNumber);
-    void lineAdded(int afterLine);
-    void lineRemoved(int lineNumber);
+    void linesAdded(int afterLine, int count);
+    void linesRemoved(int firstLine, int count);
+    void lineChanged(int lineNumber, const TokenLineDiff& diff);
+    void linesParsed(int firstLine, int count);
+    void parsingFinished();
 
 protected:
-    void addLine(int afterLine);
-    void removeLine(int lineNumber);
-    void setLine(const TokenList& tokens, int line);
+    void replaceLines(int firstLine, int oldCount, int newCount);
+    void replaceLinesInBackground(int firstLine, int oldCount, int newCount);
+    void cancelBackgroundParse();
 
     void reset();
     void parse();
-    void parse(int beginPos, int endPos);
     void parseLines(int beginLine, int endLine);
-    void parseLine(int lineNumber);
-    TokenList parseLineText(const QString& line);
-    Token parseWord(const QString& word);
+    TokenLine parseLineText(const QString& line);
 
 private slots:
     void onDocumentContentsChanged();
     void onDocumentContentsChanged(int position, int charsRemoved, int charsAdded);
     void onCursorPositionChanged(const QTextCursor& cursor);
-    void onLineCountChange(int newLineCount);
+    void onLinesTokenized(int jobId, int firstLine, const QVector<TokenLine>& lines);
+    void onBackgroundParseFinished();
 
 private:
     QTextDocument* mDoc;
     QTextCursor mCursor;
     int mCursorPos;
     bool mReceivedLongDocumentChange;
-    bool mAwaitingLineCountChange;
-    int mAwaitingLineNumber;
 
-    TokenList mTokens;
     TokenLineMap mTokensByLine;
+    int mNumTokens;
+
+    // All changes to mTokensByLine go through these, so that mNumTokens stays current
+    void setLine(int lineNumber, const TokenLine& tokens);
+    void addLines(int lineNumber, int count);
+    void removeLines(int firstLine, int count);
+
+    // Every change to the line table bumps the generation and is journaled
+    int mGeneration;
+    QVector<LineRangeChange> mJournal;
+
+    void recordChange(int firstLine, int oldCount, int newCount);
+
+    // A line range edit, in the line numbers current at the time of the edit
+    struct LineEdit
+    {
+        int firstLine;
+        int oldCount;
+        int newCount;
+    };
+
+    // The lines being tokenized in the background. Edits made since the
+    // snapshot are logged so that finished lines can be put in the right place
+    struct BackgroundJob
+    {
+        int id;
+        int firstLine;
+        QVector<LineEdit> edits;
+        QPointer<TokenizerThread> thread;
+    };
+
+    bool mBackgroundParsingEnabled;
+    BackgroundJob mJob;
+
+    int currentLineOfJobLine(int jobLine) const;
 
     int getLineNumberOfPosition(int pos) const;
     int getStartPosOfLine(int line) const;
     int getEndPosOfLine(int line) const;
 };
 
+// Walks tokens in document order without copying them. The tokens are
+// TokenSpans of the line they are in; value() and token() give their text.
+// Iterators are invalidated by any change to the tokenizer.
+class DocumentTokenizer::const_iterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef TokenSpan value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const TokenSpan* pointer;
+    typedef const TokenSpan& reference;
+
+    const_iterator();
+
+    int lineNumber() const;
+    int indexInLine() const;
+    const TokenLine& line() const;
+
+    Token::TokenType type() const;
+    QStringRef value() const;
+    Token token() const;
+
+    const TokenSpan& operator*() const;
+    const TokenSpan* operator->() const;
+    const_iterator& operator++();
+    const_iterator operator++(int);
+    bool operator==(const const_iterator& other) const;
+    bool operator!=(const const_iterator& other) const;
+
+private:
+    friend class DocumentTokenizer;
+    const_iterator(const TokenLineMap* lines, int lineNumber, int endLine);
+
+    void skipEmptyLines();
+
+    const TokenLineMap* mLines;
+    const TokenLine* mLine;
+    int mLineNumber;
+    int mIndex;
+    int mEndLine;
+};
+
+// The tokens of a range of lines, for use with range-based for loops
+class DocumentTokenizer::TokenRange
+{
+public:
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    friend class DocumentTokenizer;
+    TokenRange(const TokenLineMap* lines, int firstLine, int endLine);
+
+    const TokenLineMap* mLines;
+    int mFirstLine;
+    int mEndLine;
+};
+
+inline DocumentTokenizer::const_iterator::const_iterator() :
+    mLines(0),
+    mLine(0),
+    mLineNumber(0),
+    mIndex(0),
+    mEndLine(0)
+{
+}
+
+inline DocumentTokenizer::const_iterator::const_iterator(const TokenLineMap* lines, int lineNumber, int endLine) :
+    mLines(lines),
+    mLine(0),
+    mLineNumber(lineNumber),
+    mIndex(0),
+    mEndLine(endLine)
+{
+    skipEmptyLines();
+}
+
+inline void DocumentTokenizer::const_iterator::skipEmptyLines()
+{
+    while (mLineNumber < mEndLine && mLines->at(mLineNumber).isEmpty())
+        ++mLineNumber;
+    mLine = (mLineNumber < mEndLine) ? &mLines->at(mLineNumber) : 0;
+}
+
+inline int DocumentTokenizer::const_iterator::lineNumber() const
+{
+    return mLineNumber;
+}
+
+inline int DocumentTokenizer::const_iterator::indexInLine() const
+{
+    return mIndex;
+}
+
+inline const TokenLine& DocumentTokenizer::const_iterator::line() const
+{
+    return *mLine;
+}
+
+inline Token::TokenType DocumentTokenizer::const_iterator::type() const
+{
+    return mLine->typeAt(mIndex);
+}
+
+inline QStringRef DocumentTokenizer::const_iterator::value() const
+{
+    return mLine->valueAt(mIndex);
+}
+
+inline Token DocumentTokenizer::const_iterator::token() const
+{
+    return mLine->tokenAt(mIndex);
+}
+
+inline const TokenSpan& DocumentTokenizer::const_iterator::operator*() const
+{
+    return mLine->at(mIndex);
+}
+
+inline const TokenSpan* DocumentTokenizer::const_iterator::operator->() const
+{
+    return &mLine->at(mIndex);
+}
+
+inline DocumentTokenizer::const_iterator& DocumentTokenizer::const_iterator::operator++()
+{
+    if (++mIndex == mLine->size()) {
+        mIndex = 0;
+        ++mLineNumber;
+        skipEmptyLines();
+    }
+    return *this;
+}
+
+inline DocumentTokenizer::const_iterator DocumentTokenizer::const_iterator::operator++(int)
+{
+    const_iterator old = *this;
+    ++*this;
+    return old;
+}
+
+inline bool DocumentTokenizer::const_iterator::operator==(const const_iterator& other) const
+{
+    return mLineNumber == other.mLineNumber && mIndex == other.mIndex;
+}
+
+inline bool DocumentTokenizer::const_iterator::operator!=(const const_iterator& other) const
+{
+    return !(*this == other);
+}
+
+inline DocumentTokenizer::TokenRange::TokenRange(const TokenLineMap* lines, int firstLine, int endLine) :
+    mLines(lines),
+    mFirstLine(firstLine),
+    mEndLine(endLine)
+{
+}
+
+inline DocumentTokenizer::const_iterator DocumentTokenizer::TokenRange::begin() const
+{
+    return const_iterator(mLines, mFirstLine, mEndLine);
+}
+
+inline DocumentTokenizer::const_iterator DocumentTokenizer::TokenRange::end() const
+{
+    return const_iterator(mLines, mEndLine, mEndLine);
+}
+
+inline DocumentTokenizer::const_iterator DocumentTokenizer::begin() const
+{
+    return const_iterator(&mTokensByLine, 0, mTokensByLine.size());
+}
+
+inline DocumentTokenizer::const_iterator DocumentTokenizer::end() const
+{
+    return const_iterator(&mTokensByLine, mTokensByLine.size(), mTokensByLine.size());
+}
+
+inline DocumentTokenizer::const_iterator DocumentTokenizer::constBegin() const
+{
+    return begin();
+}
+
+inline DocumentTokenizer::const_iterator DocumentTokenizer::constEnd() const
+{
+    return end();
+}
+
 #endif // DOCUMENTTOKENIZER_H
@@ -0,0 +1,431 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "editjournal.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QThread>
+
+namespace {
+
+const quint32 JOURNAL_MAGIC = 0x41534a4c;   // "ASJL"
+const quint32 JOURNAL_VERSION = 1;
+const int STREAM_VERSION = QDataStream::Qt_5_0;
+const char* const COMPACT_SUFFIX = ".compact";
+
+enum RecordType {
+    EditRecord,
+    SnapshotRecord
+};
+
+// What the saved file looked like, so a journal is never replayed onto
+// a file that has changed underneath it
+void fileStamp(const QString& fileName, qint64* size, qint64* modified)
+{
+    QFileInfo info(fileName);
+    if (info.exists()) {
+        *size = info.size();
+        *modified = info.lastModified().toMSecsSinceEpoch();
+    } else {
+        *size = -1;
+        *modified = -1;
+    }
+}
+
+QByteArray headerRecord(const QString& baseFile)
+{
+    qint64 size;
+    qint64 modified;
+    fileStamp(baseFile, &size, &modified);
+
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    out << JOURNAL_MAGIC << JOURNAL_VERSION << size << modified;
+    return record;
+}
+
+QByteArray editRecord(int position, int charsRemoved, const QString& added)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    out << quint8(EditRecord) << qint32(position) << qint32(charsRemoved) << added;
+    return record;
+}
+
+QByteArray snapshotRecord(const QString& text)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    out << quint8(SnapshotRecord) << text;
+    return record;
+}
+
+}
+
+// Writes a compacted journal, the header and one snapshot of the text, next
+// to the real one. The EditJournal swaps it in once it is done
+class JournalCompactor : public QThread
+{
+public:
+    JournalCompactor(const QString& fileName, const QByteArray& header, const QString& text) :
+        mFileName(fileName),
+        mHeader(header),
+        mText(text),
+        mSucceeded(false)
+    {
+    }
+
+    QString fileName() const
+    {
+        return mFileName;
+    }
+
+    bool succeeded() const
+    {
+        return mSucceeded;
+    }
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        QFile file(mFileName);
+        if (!file.open(QFile::WriteOnly | QFile::Truncate))
+            return;
+
+        const QByteArray snapshot = snapshotRecord(mText);
+        mSucceeded = file.write(mHeader) == mHeader.size()
+                     && file.write(snapshot) == snapshot.size()
+                     && file.flush();
+    }
+
+private:
+    const QString mFileName;
+    const QByteArray mHeader;
+    const QString mText;
+    bool mSucceeded;
+};
+
+EditJournal::EditJournal(QTextDocument* doc, QObject* parent) :
+    QObject(parent),
+    mDocument(doc),
+    mSize(0),
+    mRevision(0),
+    mCompactor(NULL)
+{
+    mFlushTimer.setSingleShot(true);
+    mFlushTimer.setInterval(FLUSH_DELAY);
+    connect(&mFlushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+EditJournal::~EditJournal()
+{
+    stop();
+}
+
+QString EditJournal::journalFileFor(const QString& fileName)
+{
+    const QByteArray path = QFileInfo(fileName).absoluteFilePath().toUtf8();
+    const QString name = QString::fromLatin1(QCryptographicHash::hash(path, QCryptographicHash::Md5).toHex());
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return dir + "/journals/" + name + ".journal";
+}
+
+bool EditJournal::replay(const QString& journalFile, const QString& baseFile, QString* text)
+{
+    // A crash while compacting can leave only the compacted journal behind
+    QFile file(journalFile);
+    if (!file.exists())
+        file.setFileName(journalFile + COMPACT_SUFFIX);
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(STREAM_VERSION);
+
+    quint32 magic;
+    quint32 version;
+    qint64 baseSize;
+    qint64 baseModified;
+    in >> magic >> version >> baseSize >> baseModified;
+    if (in.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION)
+        return false;
+
+    qint64 size;
+    qint64 modified;
+    fileStamp(baseFile, &size, &modified);
+    if (size != baseSize || modified != baseModified)
+        return false;
+
+    QString replayed = *text;
+    while (!in.atEnd()) {
+        quint8 type;
+        in >> type;
+
+        if (type == EditRecord) {
+            qint32 position;
+            qint32 charsRemoved;
+            QString added;
+            in >> position >> charsRemoved >> added;
+            if (in.status() != QDataStream::Ok)
+                break;
+
+            // QTextDocument counts the paragraph separator at the very end
+            // of the document in some changes; the text has no such character
+            position = qBound(0, position, replayed.length());
+            charsRemoved = qBound(0, charsRemoved, replayed.length() - position);
+            replayed.replace(position, charsRemoved, added);
+        } else if (type == SnapshotRecord) {
+            QString snapshot;
+            in >> snapshot;
+            if (in.status() != QDataStream::Ok)
+                break;
+
+            replayed = snapshot;
+        } else {
+            break;
+        }
+    }
+
+    *text = replayed;
+    return true;
+}
+
+bool EditJournal::start(const QString& journalFile, const QString& baseFile)
+{
+    stop();
+
+    QDir().mkpath(QFileInfo(journalFile).absolutePath());
+    QFile::remove(journalFile + COMPACT_SUFFIX);
+
+    mJournalFile = journalFile;
+    mHeader = headerRecord(baseFile);
+    if (!rewrite())
+        return false;
+
+    // QTextDocument only emits contentsChange(int, int, int) once it has a layout
+    mDocument->documentLayout();
+    mRevision = mDocument->revision();
+    connect(mDocument, SIGNAL(contentsChange(int,int,int)),
+            this, SLOT(onContentsChange(int,int,int)), Qt::UniqueConnection);
+    return true;
+}
+
+void EditJournal::stop()
+{
+    cancelCompaction();
+    disconnect(mDocument, SIGNAL(contentsChange(int,int,int)),
+               this, SLOT(onContentsChange(int,int,int)));
+
+    mFlushTimer.stop();
+    if (mFile.isOpen())
+        mFile.close();
+}
+
+void EditJournal::discard()
+{
+    stop();
+
+    if (!mJournalFile.isEmpty()) {
+        QFile::remove(mJournalFile);
+        QFile::remove(mJournalFile + COMPACT_SUFFIX);
+        mJournalFile.clear();
+    }
+}
+
+bool EditJournal::isActive() const
+{
+    return mFile.isOpen();
+}
+
+bool EditJournal::isCompacting() const
+{
+    return mCompactor != NULL;
+}
+
+QString EditJournal::journalFile() const
+{
+    return mJournalFile;
+}
+
+qint64 EditJournal::size() const
+{
+    return mSize;
+}
+
+void EditJournal::flush()
+{
+    mFlushTimer.stop();
+    if (mFile.isOpen() && !mFile.flush()) {
+        qDebug() << "Cannot write journal" << mJournalFile << ":" << mFile.errorString();
+        stop();
+    }
+}
+
+void EditJournal::compact()
+{
+    if (!isActive() || mCompactor)
+        return;
+
+    mEditsWhileCompacting.clear();
+    mCompactor = new JournalCompactor(mJournalFile + COMPACT_SUFFIX, mHeader, mDocument->toPlainText());
+    connect(mCompactor, SIGNAL(finished()), this, SLOT(onCompactionFinished()));
+    mCompactor->start();
+}
+
+void EditJournal::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Rehighlighting a block reports it as changed without touching the text
+    // or the revision, and there's nothing to record for that
+    if (charsRemoved == charsAdded && mDocument->revision() == mRevision)
+        return;
+    mRevision = mDocument->revision();
+
+    QString added;
+    if (charsAdded > 0) {
+        // The document's last paragraph separator can be counted as added,
+        // but there's no such character to select
+        const int end = qMin(position + charsAdded, mDocument->characterCount() - 1);
+        QTextCursor cursor(mDocument);
+        cursor.setPosition(qMin(position, end));
+        cursor.setPosition(end, QTextCursor::KeepAnchor);
+        added = cursor.selectedText();
+        added.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+    }
+
+    append(editRecord(position, charsRemoved, added));
+
+    if (!mCompactor && mSize > COMPACT_MIN_SIZE
+            && mSize > COMPACT_RATIO * 2 * qint64(mDocument->characterCount()))
+        compact();
+}
+
+void EditJournal::onCompactionFinished()
+{
+    if (!mCompactor || sender() != mCompactor)
+        return;
+
+    JournalCompactor* compactor = mCompactor;
+    mCompactor = NULL;
+    compactor->deleteLater();
+
+    const QString compactFile = compactor->fileName();
+    QFile compacted(compactFile);
+    if (!compactor->succeeded() || !compacted.open(QFile::WriteOnly | QFile::Append)
+            || compacted.write(mEditsWhileCompacting) != mEditsWhileCompacting.size()
+            || !compacted.flush()) {
+        qDebug() << "Cannot compact journal" << mJournalFile;
+        compacted.close();
+        QFile::remove(compactFile);
+        mEditsWhileCompacting.clear();
+        return;
+    }
+    compacted.close();
+    mEditsWhileCompacting.clear();
+
+    // Swap the compacted journal in for the old one and carry on appending to it
+    mFile.close();
+    QFile::remove(mJournalFile);
+    if (!QFile::rename(compactFile, mJournalFile)) {
+        // The old journal is gone, so write a complete one in its place
+        // rather than appending to a file with no header
+        qDebug() << "Cannot replace journal" << mJournalFile;
+        if (rewrite())
+            QFile::remove(compactFile);
+        else
+            QFile::remove(mJournalFile);  // replay() falls back on the compacted one
+        return;
+    }
+
+    mFile.setFileName(mJournalFile);
+    if (!mFile.open(QFile::WriteOnly | QFile::Append)) {
+        qDebug() << "Cannot reopen journal" << mJournalFile << ":" << mFile.errorString();
+        stop();
+        return;
+    }
+    mSize = mFile.size();
+
+    emit compacted();
+}
+
+bool EditJournal::rewrite()
+{
+    mFile.setFileName(mJournalFile);
+    if (!mFile.open(QFile::WriteOnly | QFile::Truncate)) {
+        qDebug() << "Cannot open journal" << mJournalFile << ":" << mFile.errorString();
+        stop();
+        return false;
+    }
+
+    mSize = 0;
+    append(mHeader);
+
+    // Edits made before the journal started are only in the document
+    if (mDocument->isModified())
+        append(snapshotRecord(mDocument->toPlainText()));
+    flush();
+
+    return isActive();
+}
+
+void EditJournal::append(const QByteArray& record)
+{
+    if (!mFile.isOpen())
+        return;
+
+    if (mFile.write(record) != record.size()) {
+        qDebug() << "Cannot write journal" << mJournalFile << ":" << mFile.errorString();
+        stop();
+        return;
+    }
+    mSize += record.size();
+
+    // Edits made while the compactor works from its snapshot have to follow it
+    if (mCompactor)
+        mEditsWhileCompacting.append(record);
+
+    if (!mFlushTimer.isActive())
+        mFlushTimer.start();
+}
+
+void EditJournal::cancelCompaction()
+{
+    if (!mCompactor)
+        return;
+
+    mCompactor->disconnect(this);
+    mCompactor->wait();
+    QFile::remove(mCompactor->fileName());
+    delete mCompactor;
+    mCompactor = NULL;
+    mEditsWhileCompacting.clear();
+}
@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include "intellisense_global.h"
+
+QT_BEGIN_NAMESPACE
+class QTextDocument;
+QT_END_NAMESPACE
+
+class JournalCompactor;
+
+// Keeps an append-only record of the edits made to a document since it was
+// last saved, so they can be recovered if the editor dies before the next save.
+//
+// The journal starts with the size and modification time of the saved file it
+// applies to, followed by one record per contentsChange(): the position, the
+// number of characters removed and the text added. Each record is a single
+// buffered write, flushed to disk at most FLUSH_DELAY later. Once the journal
+// grows well past the size of the document it is compacted on a worker thread
+// into one snapshot of the text, with any edits made meanwhile appended after it.
+//
+// replay() applies a journal to the text of the file it was started against.
+// A journal for a file that has changed since is ignored, and a record cut
+// short by a crash ends the replay.
+class INTELLISENSE_EXPORT EditJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int FLUSH_DELAY = 500;                     // in milliseconds
+    static const qint64 COMPACT_MIN_SIZE = 1024 * 1024;     // in bytes
+    static const int COMPACT_RATIO = 4;                     // journal size to text size
+
+    explicit EditJournal(QTextDocument* doc, QObject* parent = 0);
+    ~EditJournal();
+
+    // Where the journal for a file lives, under the user's application data
+    static QString journalFileFor(const QString& fileName);
+
+    // Applies the journal to text, the contents of baseFile. Returns false,
+    // leaving text alone, if there is no usable journal for baseFile
+    static bool replay(const QString& journalFile, const QString& baseFile, QString* text);
+
+    // Starts a new journal against baseFile as it is on disk now. Anything
+    // in an earlier journal at the same place is thrown away
+    bool start(const QString& journalFile, const QString& baseFile);
+
+    // Stops journaling, keeping the journal file
+    void stop();
+
+    // Stops journaling and deletes the journal file
+    void discard();
+
+    bool isActive() const;
+    bool isCompacting() const;
+    QString journalFile() const;
+    qint64 size() const;
+
+public slots:
+    void flush();
+    void compact();
+
+signals:
+    void compacted();
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onCompactionFinished();
+
+private:
+    QTextDocument* mDocument;
+    QString mJournalFile;
+    QFile mFile;
+    QByteArray mHeader;
+    qint64 mSize;
+    int mRevision;
+    QTimer mFlushTimer;
+    JournalCompactor* mCompactor;
+    QByteArray mEditsWhileCompacting;
+
+    bool rewrite();
+    void append(const QByteArray& record);
+    void cancelCompaction();
+};
+
+#endif // EDITJOURNAL_H
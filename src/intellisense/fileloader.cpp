@@ -0,0 +1,231 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "fileloader.h"
+
+#include <QTextCodec>
+#include <QTextDecoder>
+#include <QTimer>
+
+FileLoader::FileLoader(const QString& fileName, QObject* parent) :
+    QObject(parent),
+    mFile(fileName),
+    mMappingAllowed(true),
+    mMapped(NULL),
+    mSequential(false),
+    mSize(0),
+    mDecoder(NULL),
+    mOffset(0),
+    mLoading(false),
+    mPendingCarriageReturn(false)
+{
+}
+
+FileLoader::~FileLoader()
+{
+    stop();
+}
+
+void FileLoader::setMemoryMapped(bool mapped)
+{
+    mMappingAllowed = mapped;
+}
+
+bool FileLoader::isMemoryMapped() const
+{
+    return mMapped != NULL;
+}
+
+bool FileLoader::open()
+{
+    if (!mFile.open(QFile::ReadOnly))
+        return false;
+
+    mSequential = mFile.isSequential();
+    mSize = mSequential ? 0 : mFile.size();
+
+    if (mMappingAllowed && !mSequential && mSize > 0)
+        mMapped = mFile.map(0, mSize);
+
+    // Pick the codec the way QTextStream does: from a byte order mark if
+    // there is one, otherwise the locale's
+    QByteArray head = mMapped ? QByteArray::fromRawData(reinterpret_cast<const char*>(mMapped),
+                                                       static_cast<int>(qMin<qint64>(mSize, 4)))
+                              : mFile.peek(4);
+    QTextCodec* codec = QTextCodec::codecForUtfText(head, QTextCodec::codecForLocale());
+    mDecoder = codec->makeDecoder();
+
+    return true;
+}
+
+QString FileLoader::errorString() const
+{
+    return mError.isEmpty() ? mFile.errorString() : mError;
+}
+
+qint64 FileLoader::size() const
+{
+    return mSize;
+}
+
+qint64 FileLoader::bytesLoaded() const
+{
+    return mOffset;
+}
+
+bool FileLoader::isSequential() const
+{
+    return mSequential;
+}
+
+bool FileLoader::isLoading() const
+{
+    return mLoading;
+}
+
+void FileLoader::start()
+{
+    if (!mDecoder)
+        return;
+
+    mLoading = true;
+    loadAndContinue(FIRST_CHUNK_SIZE);
+}
+
+void FileLoader::cancel()
+{
+    if (!mLoading)
+        return;
+
+    stop();
+    emit cancelled();
+}
+
+void FileLoader::loadNextChunk()
+{
+    if (mLoading)
+        loadAndContinue(CHUNK_SIZE);
+}
+
+void FileLoader::loadAndContinue(qint64 maxSize)
+{
+    const bool moreToLoad = loadChunk(maxSize);
+
+    // A receiver may have cancelled, or the read may have failed
+    if (!mLoading)
+        return;
+
+    if (moreToLoad) {
+        QTimer::singleShot(0, this, SLOT(loadNextChunk()));
+    } else {
+        stop();
+        emit finished();
+    }
+}
+
+bool FileLoader::loadChunk(qint64 maxSize)
+{
+    QString text;
+    bool atEnd;
+
+    if (mMapped) {
+        const qint64 length = qMin(maxSize, mSize - mOffset);
+
+        // Touching a mapped page past the end of a file that has been cut
+        // short raises SIGBUS, so make sure this chunk is still there first
+        if (mFile.size() < mOffset + length) {
+            fail(tr("The file ended early; it may have been changed while it was loading"));
+            return false;
+        }
+
+        text = mDecoder->toUnicode(reinterpret_cast<const char*>(mMapped + mOffset), static_cast<int>(length));
+        mOffset += length;
+        atEnd = mOffset >= mSize;
+    } else {
+        const qint64 wanted = mSequential ? maxSize : qMin(maxSize, mSize - mOffset);
+        const QByteArray bytes = mFile.read(wanted);
+        if (mFile.error() != QFile::NoError) {
+            fail(mFile.errorString());
+            return false;
+        }
+
+        // A regular file that comes up short has changed since it was opened,
+        // and what has been read so far is not the whole of it
+        if (!mSequential && bytes.size() < wanted) {
+            fail(tr("The file ended early; it may have been changed while it was loading"));
+            return false;
+        }
+
+        text = mDecoder->toUnicode(bytes);
+        mOffset += bytes.size();
+        atEnd = mSequential ? bytes.isEmpty() : mOffset >= mSize;
+    }
+
+    text = normalizeLineEndings(text, atEnd);
+
+    if (!text.isEmpty())
+        emit chunkLoaded(text);
+    if (mLoading)
+        emit progress(mOffset, mSize);
+
+    return !atEnd;
+}
+
+QString FileLoader::normalizeLineEndings(const QString& text, bool atEnd)
+{
+    QString normalized = text;
+
+    if (mPendingCarriageReturn) {
+        normalized.prepend(QLatin1Char('\r'));
+        mPendingCarriageReturn = false;
+    }
+
+    // Hold back a trailing '\r' in case the '\n' is at the start of the next chunk
+    if (!atEnd && normalized.endsWith(QLatin1Char('\r'))) {
+        normalized.chop(1);
+        mPendingCarriageReturn = true;
+    }
+
+    normalized.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+    return normalized;
+}
+
+void FileLoader::fail(const QString& error)
+{
+    mError = error;
+    stop();
+    emit failed();
+}
+
+void FileLoader::stop()
+{
+    mLoading = false;
+
+    if (mMapped) {
+        mFile.unmap(mMapped);
+        mMapped = NULL;
+    }
+    mFile.close();
+
+    delete mDecoder;
+    mDecoder = NULL;
+}
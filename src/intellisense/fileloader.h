@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+
+#include "intellisense_global.h"
+
+QT_BEGIN_NAMESPACE
+class QTextDecoder;
+QT_END_NAMESPACE
+
+// Reads a file a chunk at a time so a large one never has to sit in memory
+// twice, or hold up the event loop while it is decoded.
+//
+// A regular file is memory-mapped where the platform allows it and read in
+// chunks otherwise. Pipes and the like have no size up front and are read
+// until they run dry. Each chunk is decoded (a character split across two
+// chunks is carried over by the decoder), has its "\r\n" line endings
+// turned into "\n" and is handed out through chunkLoaded(). One chunk is
+// read per pass of the event loop until the file runs out, cancel() is
+// called or a read fails.
+class INTELLISENSE_EXPORT FileLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int FIRST_CHUNK_SIZE = 64 * 1024;  // enough to fill the screen
+    static const int CHUNK_SIZE = 512 * 1024;
+
+    explicit FileLoader(const QString& fileName, QObject* parent = 0);
+    ~FileLoader();
+
+    // Whether open() may map the file. On by default
+    void setMemoryMapped(bool mapped);
+    bool isMemoryMapped() const;
+
+    bool open();
+    QString errorString() const;
+
+    // The size of the file when it was opened, or 0 if it is sequential
+    qint64 size() const;
+    qint64 bytesLoaded() const;
+    bool isSequential() const;
+    bool isLoading() const;
+
+    // Decodes the first chunk straight away and the rest as the event loop
+    // gets to them
+    void start();
+
+public slots:
+    void cancel();
+
+signals:
+    void chunkLoaded(const QString& text);
+    void progress(qint64 bytesLoaded, qint64 size);
+    void finished();
+    void cancelled();
+
+    // Reading stopped part way through; errorString() says why
+    void failed();
+
+private slots:
+    void loadNextChunk();
+
+private:
+    QFile mFile;
+    bool mMappingAllowed;
+    uchar* mMapped;
+    bool mSequential;
+    qint64 mSize;
+    QTextDecoder* mDecoder;
+    qint64 mOffset;
+    bool mLoading;
+    bool mPendingCarriageReturn;
+    QString mError;
+
+    bool loadChunk(qint64 maxSize);
+    void loadAndContinue(qint64 maxSize);
+    QString normalizeLineEndings(const QString& text, bool atEnd);
+    void fail(const QString& error);
+    void stop();
+};
+
+#endif // FILELOADER_H
@@ -0,0 +1,192 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef GAPBUFFER_H
+#define GAPBUFFER_H
+
+#include <QtGlobal>
+#include <QVector>
+
+#include <algorithm> // std::swap
+
+// A sequence with a movable hole in it.
+//
+// Elements are stored in one array with a gap of unused slots at the position of
+// the last insert or remove. Inserting or removing at the gap only touches the
+// elements involved, and moving the gap costs the distance it moves, so a run of
+// edits near one spot (the cursor) stays cheap no matter how long the sequence
+// is. Random access is a single comparison away from a plain array.
+template <typename T>
+class GapBuffer
+{
+public:
+    GapBuffer();
+
+    int size() const;
+    bool isEmpty() const;
+
+    const T& at(int i) const;
+    const T& operator[](int i) const;
+    T& operator[](int i);
+
+    void insert(int i, int count, const T& value);
+    void remove(int i, int count);
+    void append(const T& value);
+    void clear();
+
+private:
+    QVector<T> mData;
+    int mGapStart;
+    int mGapEnd;
+
+    int gapSize() const;
+    int physicalIndex(int i) const;
+    void moveGapTo(int i);
+    void growGap(int minGapSize);
+};
+
+template <typename T>
+GapBuffer<T>::GapBuffer() :
+    mGapStart(0),
+    mGapEnd(0)
+{
+}
+
+template <typename T>
+inline int GapBuffer<T>::size() const
+{
+    return mData.size() - gapSize();
+}
+
+template <typename T>
+inline bool GapBuffer<T>::isEmpty() const
+{
+    return size() == 0;
+}
+
+template <typename T>
+inline const T& GapBuffer<T>::at(int i) const
+{
+    Q_ASSERT(i >= 0 && i < size());
+    return mData.at(physicalIndex(i));
+}
+
+template <typename T>
+inline const T& GapBuffer<T>::operator[](int i) const
+{
+    return at(i);
+}
+
+template <typename T>
+inline T& GapBuffer<T>::operator[](int i)
+{
+    Q_ASSERT(i >= 0 && i < size());
+    return mData[physicalIndex(i)];
+}
+
+template <typename T>
+void GapBuffer<T>::insert(int i, int count, const T& value)
+{
+    Q_ASSERT(i >= 0 && i <= size());
+    Q_ASSERT(count >= 0);
+
+    if (gapSize() < count)
+        growGap(count);
+    moveGapTo(i);
+
+    for (int j = 0; j < count; ++j) {
+        mData[mGapStart++] = value;
+    }
+}
+
+template <typename T>
+void GapBuffer<T>::remove(int i, int count)
+{
+    Q_ASSERT(i >= 0 && count >= 0 && i + count <= size());
+
+    moveGapTo(i);
+
+    // Release whatever the removed elements hold on to
+    for (int j = 0; j < count; ++j) {
+        mData[mGapEnd++] = T();
+    }
+}
+
+template <typename T>
+void GapBuffer<T>::append(const T& value)
+{
+    insert(size(), 1, value);
+}
+
+template <typename T>
+void GapBuffer<T>::clear()
+{
+    mData.clear();
+    mGapStart = 0;
+    mGapEnd = 0;
+}
+
+template <typename T>
+inline int GapBuffer<T>::gapSize() const
+{
+    return mGapEnd - mGapStart;
+}
+
+template <typename T>
+inline int GapBuffer<T>::physicalIndex(int i) const
+{
+    return (i < mGapStart) ? i : i + gapSize();
+}
+
+template <typename T>
+void GapBuffer<T>::moveGapTo(int i)
+{
+    // Elements hop from one side of the gap to the other
+    while (mGapStart > i) {
+        std::swap(mData[--mGapStart], mData[--mGapEnd]);
+    }
+    while (mGapStart < i) {
+        std::swap(mData[mGapStart++], mData[mGapEnd++]);
+    }
+}
+
+template <typename T>
+void GapBuffer<T>::growGap(int minGapSize)
+{
+    const int numElements = size();
+    const int newGapSize = qMax(minGapSize, qMax(numElements, 16));
+
+    QVector<T> newData(numElements + newGapSize);
+    for (int j = 0; j < mGapStart; ++j) {
+        std::swap(newData[j], mData[j]);
+    }
+    const int numAfterGap = mData.size() - mGapEnd;
+    const int newGapEnd = mGapStart + newGapSize;
+    for (int j = 0; j < numAfterGap; ++j) {
+        std::swap(newData[newGapEnd + j], mData[mGapEnd + j]);
+    }
+
+    mData.swap(newData);
+    mGapEnd = newGapEnd;
+}
+
+#endif // GAPBUFFER_H
@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "highlightthread.h"
+
+namespace {
+
+// Answers from the snapshot of the label index taken for one block
+class SnapshotClassifier : public LabelClassifier
+{
+public:
+    SnapshotClassifier(const HighlightThread::LabelKinds& labels, SymbolId declaredLabel) :
+        mLabels(labels),
+        mDeclaredLabel(declaredLabel)
+    {
+    }
+
+    HighlightFormat labelFormat(const QString& label, int line) const Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(line);
+        const SymbolId symbol = SymbolTable::instance()->find(label);
+        HighlightThread::LabelKinds::const_iterator i = mLabels.constFind(symbol);
+        if (i == mLabels.constEnd())
+            return BadLabelFormat;
+        if (symbol == mDeclaredLabel)
+            return (i.value() & HighlightThread::Duplicate) ? DuplicateLabelFormat : LabelDeclarationFormat;
+        if (i.value() & HighlightThread::Function)
+            return FunctionLabelFormat;
+        return VariableLabelFormat;
+    }
+
+private:
+    const HighlightThread::LabelKinds& mLabels;
+    const SymbolId mDeclaredLabel;
+};
+
+}
+
+FormatRuns LabelClassifier::formatRuns(const TokenLine& tokens, int line, const LabelClassifier& labels)
+{
+    FormatRuns runs;
+    runs.reserve(tokens.size());
+    for (int i = 0; i < tokens.size(); ++i) {
+        const TokenSpan& span = tokens.at(i);
+        HighlightFormat format = NoFormat;
+        switch (span.type) {
+        case Token::Label:
+            format = labels.labelFormat(tokens.valueAt(i).toString(), line);
+            break;
+        case Token::Instruction:
+            format = KeywordFormat;
+            break;
+        case Token::IntLiteral:
+            format = NumberFormat;
+            break;
+        case Token::CharLiteral:
+            format = QuotationFormat;
+            break;
+        case Token::Include:
+            format = IncludeFormat;
+            break;
+        case Token::IncludeFile:
+            format = IncludeFileFormat;
+            break;
+        case Token::Comment:
+            format = CommentFormat;
+            break;
+        default:
+            break;
+        }
+
+        if (format != NoFormat) {
+            FormatRun run = {span.column, span.length, format};
+            runs.push_back(run);
+        }
+    }
+    return runs;
+}
+
+HighlightThread::HighlightThread(int jobId, const QVector<BlockSnapshot>& blocks, const LabelKinds& labels,
+                                 QObject* parent) :
+    QThread(parent),
+    mJobId(jobId),
+    mBlocks(blocks),
+    mLabels(labels),
+    mCancelled(0)
+{
+}
+
+int HighlightThread::jobId() const
+{
+    return mJobId;
+}
+
+void HighlightThread::cancel()
+{
+    mCancelled.store(1);
+}
+
+void HighlightThread::run()
+{
+    QVector<BlockFormats> chunk;
+    chunk.reserve(CHUNK_SIZE);
+
+    foreach (const BlockSnapshot& block, mBlocks) {
+        if (mCancelled.load())
+            return;
+
+        const SnapshotClassifier classifier(mLabels, block.declaredLabel);
+        BlockFormats formats = {block.line, block.revision, block.tokens.text(),
+                                LabelClassifier::formatRuns(block.tokens, block.line, classifier)};
+        chunk.push_back(formats);
+
+        if (chunk.size() == CHUNK_SIZE) {
+            emit blocksFormatted(mJobId, chunk);
+            chunk.clear();
+            chunk.reserve(CHUNK_SIZE);
+        }
+    }
+
+    if (!chunk.isEmpty() && !mCancelled.load())
+        emit blocksFormatted(mJobId, chunk);
+}
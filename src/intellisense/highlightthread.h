@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HIGHLIGHTTHREAD_H
+#define HIGHLIGHTTHREAD_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMetaType>
+#include <QThread>
+#include <QVector>
+
+#include "intellisense_global.h"
+#include "symboltable.h"
+#include "tokenline.h"
+
+// The formats the SyntaxHighlighter can give a piece of text
+enum HighlightFormat
+{
+    NoFormat,
+    LabelDeclarationFormat,
+    DuplicateLabelFormat,
+    FunctionLabelFormat,
+    VariableLabelFormat,
+    BadLabelFormat,
+    KeywordFormat,
+    NumberFormat,
+    QuotationFormat,
+    IncludeFormat,
+    IncludeFileFormat,
+    CommentFormat,
+    NUM_FORMATS
+};
+
+// One stretch of a block drawn in one format
+struct FormatRun
+{
+    int start;
+    int length;
+    HighlightFormat format;
+};
+
+typedef QVector<FormatRun> FormatRuns;
+
+// Decides how a label is drawn where it appears on a line
+class INTELLISENSE_EXPORT LabelClassifier
+{
+public:
+    virtual ~LabelClassifier() {}
+    virtual HighlightFormat labelFormat(const QString& label, int line) const = 0;
+
+    // The runs for a line of tokens. Only labels need the classifier
+    static FormatRuns formatRuns(const TokenLine& tokens, int line, const LabelClassifier& labels);
+};
+
+// A copy of a block taken on the GUI thread, with the label it declares
+struct BlockSnapshot
+{
+    int line;
+    int revision;
+    TokenLine tokens;
+    SymbolId declaredLabel;
+};
+
+// The runs worked out for a BlockSnapshot. They only apply while the block
+// still has the same revision and text
+struct BlockFormats
+{
+    int line;
+    int revision;
+    QString text;
+    FormatRuns runs;
+};
+
+Q_DECLARE_METATYPE(BlockFormats)
+
+// Works out the format runs of a batch of blocks off the GUI thread.
+//
+// Everything it reads is handed over up front: the tokens of the blocks and
+// what each label in the document is (defined, a function, duplicated). The
+// runs come back through blocksFormatted() in chunks, and it is up to the
+// receiver to drop any whose block has changed in the meantime.
+class INTELLISENSE_EXPORT HighlightThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    static const int CHUNK_SIZE = 500;
+
+    enum LabelKind {
+        Function = 0x1,
+        Duplicate = 0x2
+    };
+
+    // Every label that is defined, with its LabelKind flags
+    typedef QHash<SymbolId, int> LabelKinds;
+
+    HighlightThread(int jobId, const QVector<BlockSnapshot>& blocks, const LabelKinds& labels,
+                    QObject* parent = 0);
+
+    int jobId() const;
+    void cancel();
+
+signals:
+    void blocksFormatted(int jobId, const QVector<BlockFormats>& blocks);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    const int mJobId;
+    const QVector<BlockSnapshot> mBlocks;
+    const LabelKinds mLabels;
+    QAtomicInt mCancelled;
+};
+
+#endif // HIGHLIGHTTHREAD_H
@@ -23,20 +23,50 @@
 TARGET = Intellisense
 TEMPLATE = lib
 
+CONFIG += c++11
+
 DEFINES += INTELLISENSE_LIBRARY
 
 SOURCES += syntaxhighlighter.cpp \
     documenttokenizer.cpp \
     token.cpp \
     documentlabelindex.cpp \
-    autocompletermodel.cpp
+    autocompletermodel.cpp \
+    linelexer.cpp \
+    tokenline.cpp \
+    mnemonictable.cpp \
+    tokenizerthread.cpp \
+    textscanner.cpp \
+    tokenblockdata.cpp \
+    symboltable.cpp \
+    completionengine.cpp \
+    highlightthread.cpp \
+    editjournal.cpp \
+    fileloader.cpp \
+    savethread.cpp \
+    documentsaver.cpp
 
 HEADERS += syntaxhighlighter.h \ 
     documenttokenizer.h \
     token.h \
     intellisense_global.h \
     documentlabelindex.h \
-    autocompletermodel.h
+    autocompletermodel.h \
+    linelexer.h \
+    tokenline.h \
+    mnemonictable.h \
+    gapbuffer.h \
+    lineanchormap.h \
+    tokenizerthread.h \
+    textscanner.h \
+    tokenblockdata.h \
+    symboltable.h \
+    completionengine.h \
+    highlightthread.h \
+    editjournal.h \
+    fileloader.h \
+    savethread.h \
+    documentsaver.h
 
 unix {
     target.path = /usr/lib
@@ -0,0 +1,338 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LINEANCHORMAP_H
+#define LINEANCHORMAP_H
+
+#include <QtGlobal>
+
+// Values pinned to line numbers that move as lines are inserted and removed.
+//
+// The anchors live in a treap ordered by line. Instead of renumbering every
+// anchor below an edit, shift() splits the tree at the edit and leaves a pending
+// offset on the root of the lower part, which is pushed down only when that part
+// is restructured. So a shift costs O(log n) no matter where the edit is, and
+// the current line of an anchor is the sum of the offsets above it.
+//
+// At most one anchor sits on each line. Anchor pointers stay valid until the
+// anchor is removed.
+template <typename T>
+class LineAnchorMap
+{
+public:
+    class Anchor
+    {
+    public:
+        const T& value() const { return mValue; }
+
+    private:
+        friend class LineAnchorMap<T>;
+
+        int mLine;
+        int mPendingShift;
+        quint32 mPriority;
+        Anchor* mLeft;
+        Anchor* mRight;
+        Anchor* mParent;
+        T mValue;
+    };
+
+    LineAnchorMap();
+    ~LineAnchorMap();
+
+    int size() const;
+    bool isEmpty() const;
+    void clear();
+
+    Anchor* insert(int line, const T& value);
+    void remove(Anchor* anchor);
+
+    int lineOf(const Anchor* anchor) const;
+    Anchor* find(int line) const;
+    Anchor* lowerBound(int line) const;
+    Anchor* first() const;
+    Anchor* next(const Anchor* anchor) const;
+
+    // Moves every anchor at or after fromLine by delta lines. The lines being
+    // moved over must not hold anchors.
+    void shift(int fromLine, int delta);
+
+private:
+    Q_DISABLE_COPY(LineAnchorMap)
+
+    Anchor* mRoot;
+    int mSize;
+    quint32 mRandomState;
+
+    quint32 nextPriority();
+    static void push(Anchor* anchor);
+    static void split(Anchor* tree, int line, Anchor*& before, Anchor*& after);
+    static Anchor* merge(Anchor* before, Anchor* after);
+    static void deleteTree(Anchor* tree);
+};
+
+template <typename T>
+LineAnchorMap<T>::LineAnchorMap() :
+    mRoot(0),
+    mSize(0),
+    mRandomState(2463534242u)
+{
+}
+
+template <typename T>
+LineAnchorMap<T>::~LineAnchorMap()
+{
+    deleteTree(mRoot);
+}
+
+template <typename T>
+inline int LineAnchorMap<T>::size() const
+{
+    return mSize;
+}
+
+template <typename T>
+inline bool LineAnchorMap<T>::isEmpty() const
+{
+    return mSize == 0;
+}
+
+template <typename T>
+void LineAnchorMap<T>::clear()
+{
+    deleteTree(mRoot);
+    mRoot = 0;
+    mSize = 0;
+}
+
+template <typename T>
+typename LineAnchorMap<T>::Anchor* LineAnchorMap<T>::insert(int line, const T& value)
+{
+    Q_ASSERT(!find(line));
+
+    Anchor* anchor = new Anchor;
+    anchor->mLine = line;
+    anchor->mPendingShift = 0;
+    anchor->mPriority = nextPriority();
+    anchor->mLeft = 0;
+    anchor->mRight = 0;
+    anchor->mParent = 0;
+    anchor->mValue = value;
+
+    Anchor* before;
+    Anchor* after;
+    split(mRoot, line, before, after);
+    mRoot = merge(merge(before, anchor), after);
+    mRoot->mParent = 0;
+    ++mSize;
+    return anchor;
+}
+
+template <typename T>
+void LineAnchorMap<T>::remove(Anchor* anchor)
+{
+    Q_ASSERT(anchor);
+
+    // Cut the anchor's line out of the tree and join what is left
+    const int line = lineOf(anchor);
+    Anchor* before;
+    Anchor* rest;
+    Anchor* middle;
+    Anchor* after;
+    split(mRoot, line, before, rest);
+    split(rest, line + 1, middle, after);
+    Q_ASSERT(middle == anchor && !anchor->mLeft && !anchor->mRight);
+    delete middle;
+
+    mRoot = merge(before, after);
+    if (mRoot)
+        mRoot->mParent = 0;
+    --mSize;
+}
+
+template <typename T>
+int LineAnchorMap<T>::lineOf(const Anchor* anchor) const
+{
+    // Every ancestor's pending shift applies to the anchor
+    int line = anchor->mLine;
+    for (const Anchor* a = anchor->mParent; a; a = a->mParent) {
+        line += a->mPendingShift;
+    }
+    return line;
+}
+
+template <typename T>
+typename LineAnchorMap<T>::Anchor* LineAnchorMap<T>::find(int line) const
+{
+    Anchor* anchor = lowerBound(line);
+    return (anchor && lineOf(anchor) == line) ? anchor : 0;
+}
+
+template <typename T>
+typename LineAnchorMap<T>::Anchor* LineAnchorMap<T>::lowerBound(int line) const
+{
+    Anchor* best = 0;
+    Anchor* a = mRoot;
+    int shift = 0;
+    while (a) {
+        if (a->mLine + shift >= line) {
+            best = a;
+            shift += a->mPendingShift;
+            a = a->mLeft;
+        } else {
+            shift += a->mPendingShift;
+            a = a->mRight;
+        }
+    }
+    return best;
+}
+
+template <typename T>
+typename LineAnchorMap<T>::Anchor* LineAnchorMap<T>::first() const
+{
+    Anchor* a = mRoot;
+    while (a && a->mLeft)
+        a = a->mLeft;
+    return a;
+}
+
+template <typename T>
+typename LineAnchorMap<T>::Anchor* LineAnchorMap<T>::next(const Anchor* anchor) const
+{
+    if (anchor->mRight) {
+        Anchor* a = anchor->mRight;
+        while (a->mLeft)
+            a = a->mLeft;
+        return a;
+    }
+
+    // Climb until we come up out of a left subtree
+    while (anchor->mParent && anchor->mParent->mRight == anchor)
+        anchor = anchor->mParent;
+    return anchor->mParent;
+}
+
+template <typename T>
+void LineAnchorMap<T>::shift(int fromLine, int delta)
+{
+    if (delta == 0)
+        return;
+
+    Anchor* before;
+    Anchor* after;
+    split(mRoot, fromLine, before, after);
+    if (after) {
+        after->mLine += delta;
+        after->mPendingShift += delta;
+    }
+    mRoot = merge(before, after);
+    if (mRoot)
+        mRoot->mParent = 0;
+}
+
+template <typename T>
+quint32 LineAnchorMap<T>::nextPriority()
+{
+    // xorshift32
+    mRandomState ^= mRandomState << 13;
+    mRandomState ^= mRandomState >> 17;
+    mRandomState ^= mRandomState << 5;
+    return mRandomState;
+}
+
+template <typename T>
+void LineAnchorMap<T>::push(Anchor* anchor)
+{
+    // Hand the pending shift down to the children. The anchor's own line
+    // already includes it.
+    if (anchor->mPendingShift == 0)
+        return;
+    if (anchor->mLeft) {
+        anchor->mLeft->mLine += anchor->mPendingShift;
+        anchor->mLeft->mPendingShift += anchor->mPendingShift;
+    }
+    if (anchor->mRight) {
+        anchor->mRight->mLine += anchor->mPendingShift;
+        anchor->mRight->mPendingShift += anchor->mPendingShift;
+    }
+    anchor->mPendingShift = 0;
+}
+
+template <typename T>
+void LineAnchorMap<T>::split(Anchor* tree, int line, Anchor*& before, Anchor*& after)
+{
+    // The root of tree has no pending shifts above it, so its line is current
+    if (!tree) {
+        before = after = 0;
+        return;
+    }
+
+    push(tree);
+    if (tree->mLine < line) {
+        split(tree->mRight, line, tree->mRight, after);
+        if (tree->mRight)
+            tree->mRight->mParent = tree;
+        before = tree;
+    } else {
+        split(tree->mLeft, line, before, tree->mLeft);
+        if (tree->mLeft)
+            tree->mLeft->mParent = tree;
+        after = tree;
+    }
+    if (before)
+        before->mParent = 0;
+    if (after)
+        after->mParent = 0;
+}
+
+template <typename T>
+typename LineAnchorMap<T>::Anchor* LineAnchorMap<T>::merge(Anchor* before, Anchor* after)
+{
+    if (!before)
+        return after;
+    if (!after)
+        return before;
+
+    if (before->mPriority > after->mPriority) {
+        push(before);
+        before->mRight = merge(before->mRight, after);
+        before->mRight->mParent = before;
+        return before;
+    } else {
+        push(after);
+        after->mLeft = merge(before, after->mLeft);
+        after->mLeft->mParent = after;
+        return after;
+    }
+}
+
+template <typename T>
+void LineAnchorMap<T>::deleteTree(Anchor* tree)
+{
+    if (!tree)
+        return;
+    deleteTree(tree->mLeft);
+    deleteTree(tree->mRight);
+    delete tree;
+}
+
+#endif // LINEANCHORMAP_H
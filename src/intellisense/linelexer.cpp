@@ -0,0 +1,281 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "linelexer.h"
+
+#include <QStringList>
+
+#include "mnemonictable.h"
+#include "textscanner.h"
+
+namespace {
+
+// Character classes that drive the word classifier
+enum CharClass
+{
+    CC_Space,
+    CC_Letter,      // ASCII letter that is not a hex digit
+    CC_HexLetter,   // a-f, A-F
+    CC_X,           // lowercase 'x' (for the "0x" prefix)
+    CC_Zero,
+    CC_Digit,       // 1-9
+    CC_Minus,
+    CC_Quote,
+    CC_Dot,
+    CC_Slash,
+    CC_Underscore,
+    CC_WordOther,   // non-ASCII letter, number or mark
+    CC_Other,
+    NUM_CHAR_CLASSES
+};
+
+#define SP CC_Space
+#define LT CC_Letter
+#define HX CC_HexLetter
+#define XX CC_X
+#define ZR CC_Zero
+#define DG CC_Digit
+#define MN CC_Minus
+#define QT CC_Quote
+#define DT CC_Dot
+#define SL CC_Slash
+#define US CC_Underscore
+#define OT CC_Other
+
+const quint8 ASCII_CLASSES[128] = {
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, SP, SP, SP, SP, SP, OT, OT,  // 0x00
+    OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT, OT,  // 0x10
+    SP, OT, OT, OT, OT, OT, OT, QT, OT, OT, OT, OT, OT, MN, DT, SL,  // 0x20
+    ZR, DG, DG, DG, DG, DG, DG, DG, DG, DG, OT, OT, OT, OT, OT, OT,  // 0x30
+    OT, HX, HX, HX, HX, HX, HX, LT, LT, LT, LT, LT, LT, LT, LT, LT,  // 0x40
+    LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, LT, OT, OT, OT, OT, US,  // 0x50
+    OT, HX, HX, HX, HX, HX, HX, LT, LT, LT, LT, LT, LT, LT, LT, LT,  // 0x60
+    LT, LT, LT, LT, LT, LT, LT, LT, XX, LT, LT, OT, OT, OT, OT, OT   // 0x70
+};
+
+#undef SP
+#undef LT
+#undef HX
+#undef XX
+#undef ZR
+#undef DG
+#undef MN
+#undef QT
+#undef DT
+#undef SL
+#undef US
+#undef OT
+
+// States of the word classifier. The accepting states correspond to
+// Token::REGEX[Label], Token::REGEX[IntLiteral] and Token::REGEX[CharLiteral].
+enum State
+{
+    S_Start,
+    S_Label,        // [A-Za-z]\w*
+    S_Minus,        // -
+    S_Zero,         // 0
+    S_Decimal,      // -?[0-9]+
+    S_HexPrefix,    // 0x
+    S_Hex,          // 0x[0-9a-fA-F]+
+    S_QuoteOpen,    // '
+    S_QuoteChar,    // '.
+    S_CharLiteral,  // '.'
+    S_Dead,
+    NUM_STATES
+};
+
+const quint8 TRANSITIONS[NUM_STATES][NUM_CHAR_CLASSES] = {
+    //             Space        Letter       HexLetter    X            Zero         Digit        Minus        Quote          Dot          Slash        Underscore   WordOther    Other
+    /* Start */  { S_Dead,      S_Label,     S_Label,     S_Label,     S_Zero,      S_Decimal,   S_Minus,     S_QuoteOpen,   S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* Label */  { S_Dead,      S_Label,     S_Label,     S_Label,     S_Label,     S_Label,     S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Label,     S_Label,     S_Dead      },
+    /* Minus */  { S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Decimal,   S_Decimal,   S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* Zero */   { S_Dead,      S_Dead,      S_Dead,      S_HexPrefix, S_Decimal,   S_Decimal,   S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* Decimal */{ S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Decimal,   S_Decimal,   S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* HexPre */ { S_Dead,      S_Dead,      S_Hex,       S_Dead,      S_Hex,       S_Hex,       S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* Hex */    { S_Dead,      S_Dead,      S_Hex,       S_Dead,      S_Hex,       S_Hex,       S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* QOpen */  { S_QuoteChar, S_QuoteChar, S_QuoteChar, S_QuoteChar, S_QuoteChar, S_QuoteChar, S_QuoteChar, S_QuoteChar,   S_QuoteChar, S_QuoteChar, S_QuoteChar, S_QuoteChar, S_QuoteChar },
+    /* QChar */  { S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_CharLiteral, S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* CharLit */{ S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      },
+    /* Dead */   { S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead,        S_Dead,      S_Dead,      S_Dead,      S_Dead,      S_Dead      }
+};
+
+// Classes that may appear in an included file name ([\./\w])
+const quint16 PATH_CLASSES = (1 << CC_Letter) | (1 << CC_HexLetter) | (1 << CC_X) |
+                             (1 << CC_Zero) | (1 << CC_Digit) | (1 << CC_Dot) |
+                             (1 << CC_Slash) | (1 << CC_Underscore) | (1 << CC_WordOther);
+
+inline CharClass classOf(QChar c)
+{
+    const ushort u = c.unicode();
+    if (u < 0x80)
+        return static_cast<CharClass>(ASCII_CLASSES[u]);
+    if (c.isLetterOrNumber() || c.isMark())
+        return CC_WordOther;
+    if (c.isSpace())
+        return CC_Space;
+    return CC_Other;
+}
+
+inline bool isIncludeDirective(const QChar* word, int length)
+{
+    static const QString INCLUDE("#include");
+    return length == INCLUDE.length() && QString::fromRawData(word, length) == INCLUDE;
+}
+
+inline bool startsComment(const QChar* c, const QChar* end)
+{
+    return c[0] == QLatin1Char('/') && c + 1 < end && c[1] == QLatin1Char('/');
+}
+
+} // namespace
+
+TokenLine LineLexer::tokenize(const QString& line)
+{
+    TokenLine tokensInLine(line);
+
+    const QChar* const begin = line.constData();
+    const QChar* const end = begin + line.length();
+    const QChar* c = begin;
+
+    while (c < end) {
+        // Skip any whitespace between words. The scanner stops at non-ASCII characters, which may
+        // still be spaces
+        c = TextScanner::skipAsciiSpaces(c, end);
+        if (c == end)
+            break;
+        if (isSpace(*c)) {
+            ++c;
+            continue;
+        }
+
+        // A comment swallows the rest of the line
+        if (startsComment(c, end)) {
+            tokensInLine.append(Token::Comment, static_cast<int>(c - begin), static_cast<int>(end - c));
+            break;
+        }
+
+        // Otherwise read one word, which ends at whitespace or at a comment
+        const QChar* wordBegin = c;
+        // Every character the scanner stops at other than a space or a comment is part of the word
+        while (c < end) {
+            c = TextScanner::findWordBreak(c, end);
+            if (c == end || isSpace(*c) || startsComment(c, end))
+                break;
+            ++c;
+        }
+
+        const int wordLength = static_cast<int>(c - wordBegin);
+        tokensInLine.append(classify(wordBegin, wordLength), static_cast<int>(wordBegin - begin), wordLength);
+    }
+
+    // Add a newline token to the end of every line
+    tokensInLine.appendNewline();
+
+    return tokensInLine;
+}
+
+Token::TokenType LineLexer::classify(const QChar* word, int length)
+{
+    if (length <= 0)
+        return Token::Unrecognized;
+
+    int state = S_Start;
+    quint16 seenClasses = 0;
+    for (int i = 0; i < length; ++i) {
+        const CharClass charClass = classOf(word[i]);
+        seenClasses |= 1 << charClass;
+        state = TRANSITIONS[state][charClass];
+    }
+
+    // Order matters here: it mirrors the order of Token::REGEX
+    if (state == S_Label && MnemonicTable::lookup(word, length))
+        return Token::Instruction;
+    if (word[0] == QLatin1Char('#') && isIncludeDirective(word, length))
+        return Token::Include;
+    if (length >= 3 && (seenClasses & ~PATH_CLASSES) == 0 &&
+            word[length - 2] == QLatin1Char('.') && word[length - 1] == QLatin1Char('e'))
+        return Token::IncludeFile;
+
+    switch (state) {
+    case S_Label:
+        return Token::Label;
+    case S_Zero:
+    case S_Decimal:
+    case S_Hex:
+        return Token::IntLiteral;
+    case S_CharLiteral:
+        return Token::CharLiteral;
+    default:
+        return Token::Unrecognized;
+    }
+}
+
+Token::TokenType LineLexer::classify(const QString& word)
+{
+    return classify(word.constData(), word.length());
+}
+
+TokenList LineLexer::tokenizeWithRegex(const QString& line)
+{
+    TokenList tokensInLine;
+
+    // Watch out for comments!
+    int indexOfComment = Token::REGEX[Token::Comment].indexIn(line);
+    if (indexOfComment >= 0)
+    {
+        // Parse the part of the line that comes before the comment
+        QString beginningOfLine = line.left(indexOfComment);
+        tokensInLine = tokenizeWithRegex(beginningOfLine);
+
+        // Remove newline token from that parsed list
+        tokensInLine.pop_back();
+
+        // Add the comment token
+        QString commentString = line.right(line.length() - indexOfComment);
+        Token comment = {commentString, classifyWithRegex(commentString)};
+        tokensInLine.push_back(comment);
+    }
+    else
+    {
+        // If not a comment, split the line into words and parse each word
+        QStringList words = line.split(Token::REGEX[Token::Whitespace], QString::SkipEmptyParts);
+        foreach (const QString& word, words) {
+            Token token = {word, classifyWithRegex(word)};
+            tokensInLine.push_back(token);
+        }
+    }
+
+    // Add a newline token to the end of every line
+    Token newline = {"\n", Token::Newline};
+    tokensInLine.push_back(newline);
+
+    return tokensInLine;
+}
+
+Token::TokenType LineLexer::classifyWithRegex(const QString& word)
+{
+    for (int i = 0; i < Token::NUM_TOKEN_TYPES - 1; ++i) {
+        if (Token::REGEX[i].exactMatch(word))
+            return static_cast<Token::TokenType>(i);
+    }
+    return Token::Unrecognized;
+}
@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LINELEXER_H
+#define LINELEXER_H
+
+#include <QChar>
+#include <QString>
+
+#include "intellisense_global.h"
+#include "token.h"
+#include "tokenline.h"
+
+// Splits a single line of E100 source into tokens.
+//
+// The lexer walks the line exactly once, character by character, and classifies
+// each word with a table-driven state machine. It produces the same tokens as the
+// original Token::REGEX cascade, which is kept around (tokenizeWithRegex) as the
+// reference implementation the tests check the lexer against.
+class INTELLISENSE_EXPORT LineLexer
+{
+public:
+    static TokenLine tokenize(const QString& line);
+    static Token::TokenType classify(const QChar* word, int length);
+    static Token::TokenType classify(const QString& word);
+
+    static TokenList tokenizeWithRegex(const QString& line);
+    static Token::TokenType classifyWithRegex(const QString& word);
+
+    static bool isSpace(QChar c);
+};
+
+inline bool LineLexer::isSpace(QChar c)
+{
+    const ushort u = c.unicode();
+    if (u < 0x80)
+        return u == ' ' || (u >= '\t' && u <= '\r');
+    return c.isSpace();
+}
+
+#endif // LINELEXER_H
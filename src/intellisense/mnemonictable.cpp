@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "mnemonictable.h"
+
+namespace {
+
+constexpr Mnemonic MNEMONICS[Mnemonic::NUM_OPCODES] = {
+    {"halt", Mnemonic::Halt, 0},
+    {"add",  Mnemonic::Add,  3},
+    {"sub",  Mnemonic::Sub,  3},
+    {"mult", Mnemonic::Mult, 3},
+    {"div",  Mnemonic::Div,  3},
+    {"cp",   Mnemonic::Cp,   2},
+    {"and",  Mnemonic::And,  3},
+    {"or",   Mnemonic::Or,   3},
+    {"not",  Mnemonic::Not,  2},
+    {"sl",   Mnemonic::Sl,   3},
+    {"sr",   Mnemonic::Sr,   3},
+    {"cpfa", Mnemonic::Cpfa, 3},
+    {"cpta", Mnemonic::Cpta, 3},
+    {"be",   Mnemonic::Be,   3},
+    {"bne",  Mnemonic::Bne,  3},
+    {"blt",  Mnemonic::Blt,  3},
+    {"call", Mnemonic::Call, 2},
+    {"ret",  Mnemonic::Ret,  1}
+};
+
+const int TABLE_SIZE = 32;
+
+// The hash only looks at the first and the last two (lowercased) characters,
+// which is enough to tell every E100 mnemonic apart.
+constexpr int hashOf(int first, int secondToLast, int last)
+{
+    return (first + 3 * secondToLast + 18 * last) & (TABLE_SIZE - 1);
+}
+
+constexpr int lengthOf(const char* name)
+{
+    return *name ? 1 + lengthOf(name + 1) : 0;
+}
+
+constexpr int hashOf(const char* name)
+{
+    return hashOf(name[0], name[lengthOf(name) - 2], name[lengthOf(name) - 1]);
+}
+
+// Returns the index of the mnemonic (searching from index i) that hashes to h, or -1
+constexpr int slotFor(int h, int i = 0)
+{
+    return i == Mnemonic::NUM_OPCODES ? -1 :
+           hashOf(MNEMONICS[i].name) == h ? i :
+           slotFor(h, i + 1);
+}
+
+constexpr qint8 SLOTS[TABLE_SIZE] = {
+    slotFor(0),  slotFor(1),  slotFor(2),  slotFor(3),  slotFor(4),  slotFor(5),  slotFor(6),  slotFor(7),
+    slotFor(8),  slotFor(9),  slotFor(10), slotFor(11), slotFor(12), slotFor(13), slotFor(14), slotFor(15),
+    slotFor(16), slotFor(17), slotFor(18), slotFor(19), slotFor(20), slotFor(21), slotFor(22), slotFor(23),
+    slotFor(24), slotFor(25), slotFor(26), slotFor(27), slotFor(28), slotFor(29), slotFor(30), slotFor(31)
+};
+
+// Every mnemonic must own its slot, otherwise two mnemonics collide
+constexpr bool isPerfect(int i = 0)
+{
+    return i == Mnemonic::NUM_OPCODES ||
+           (SLOTS[hashOf(MNEMONICS[i].name)] == i &&
+            MNEMONICS[i].opcode == i &&
+            lengthOf(MNEMONICS[i].name) >= MnemonicTable::MIN_LENGTH &&
+            lengthOf(MNEMONICS[i].name) <= MnemonicTable::MAX_LENGTH &&
+            isPerfect(i + 1));
+}
+
+static_assert(isPerfect(), "MNEMONICS does not hash perfectly into SLOTS; pick new hash constants");
+
+} // namespace
+
+const Mnemonic* MnemonicTable::lookup(const QChar* word, int length)
+{
+    if (length < MIN_LENGTH || length > MAX_LENGTH)
+        return NULL;
+
+    // Lowercase the word. Only ASCII letters can survive the comparison below,
+    // since c | 0x20 is a lowercase letter only when c is a letter.
+    ushort lowered[MAX_LENGTH];
+    for (int i = 0; i < length; ++i) {
+        const ushort c = word[i].unicode();
+        if (c >= 0x80)
+            return NULL;
+        lowered[i] = c | 0x20;
+    }
+
+    const int slot = SLOTS[hashOf(lowered[0], lowered[length - 2], lowered[length - 1])];
+    if (slot < 0)
+        return NULL;
+
+    const Mnemonic& mnemonic = MNEMONICS[slot];
+    for (int i = 0; i < length; ++i) {
+        if (lowered[i] != static_cast<ushort>(mnemonic.name[i]))
+            return NULL;
+    }
+    return mnemonic.name[length] == '\0' ? &mnemonic : NULL;
+}
+
+const Mnemonic* MnemonicTable::lookup(const QString& word)
+{
+    return lookup(word.constData(), word.length());
+}
+
+const Mnemonic& MnemonicTable::at(Mnemonic::Opcode opcode)
+{
+    Q_ASSERT(opcode >= 0 && opcode < Mnemonic::NUM_OPCODES);
+    return MNEMONICS[opcode];
+}
+
+QStringList MnemonicTable::names()
+{
+    QStringList names;
+    for (const Mnemonic& mnemonic : MNEMONICS) {
+        names.push_back(QLatin1String(mnemonic.name));
+    }
+    return names;
+}
@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MNEMONICTABLE_H
+#define MNEMONICTABLE_H
+
+#include <QChar>
+#include <QString>
+#include <QStringList>
+
+#include "intellisense_global.h"
+
+// One E100 instruction. The opcode is the instruction's number in the E100
+// instruction set.
+struct Mnemonic
+{
+    enum Opcode
+    {
+        Halt,
+        Add,
+        Sub,
+        Mult,
+        Div,
+        Cp,
+        And,
+        Or,
+        Not,
+        Sl,
+        Sr,
+        Cpfa,
+        Cpta,
+        Be,
+        Bne,
+        Blt,
+        Call,
+        Ret,
+        NUM_OPCODES
+    };
+
+    const char* name;
+    Opcode opcode;
+    int numOperands;
+};
+
+// The E100 instruction set.
+//
+// Mnemonics are found through a perfect hash that is checked at compile time,
+// so recognizing a word costs one table probe and one short comparison, and
+// never allocates. Matching is case-insensitive, like Token::REGEX[Instruction].
+class INTELLISENSE_EXPORT MnemonicTable
+{
+public:
+    static const int MIN_LENGTH = 2;
+    static const int MAX_LENGTH = 4;
+
+    static const Mnemonic* lookup(const QChar* word, int length);
+    static const Mnemonic* lookup(const QString& word);
+    static const Mnemonic& at(Mnemonic::Opcode opcode);
+    static QStringList names();
+};
+
+#endif // MNEMONICTABLE_H
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "savethread.h"
+
+#include <QSaveFile>
+#include <QTextStream>
+
+SaveThread::SaveThread(const QString& fileName, const QString& text, QObject* parent) :
+    QThread(parent),
+    mFileName(fileName),
+    mSnapshot(text),
+    mSaved(false)
+{
+}
+
+QString SaveThread::fileName() const
+{
+    return mFileName;
+}
+
+bool SaveThread::succeeded() const
+{
+    return mSaved;
+}
+
+QString SaveThread::errorString() const
+{
+    return mError;
+}
+
+void SaveThread::run()
+{
+    QSaveFile file(mFileName);
+    if (!file.open(QFile::WriteOnly | QFile::Text)) {
+        mError = file.errorString();
+        return;
+    }
+
+    QTextStream out(&file);
+    out << mSnapshot;
+    out.flush();
+
+    // Nothing on disk changes unless every byte made it into the temporary file
+    if (out.status() != QTextStream::Ok || !file.commit()) {
+        mError = file.errorString();
+        return;
+    }
+
+    mSaved = true;
+}
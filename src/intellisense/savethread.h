@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SAVETHREAD_H
+#define SAVETHREAD_H
+
+#include <QString>
+#include <QThread>
+
+#include "intellisense_global.h"
+
+// Writes a snapshot of a document's text to disk off the GUI thread.
+//
+// The text is encoded and written through a QSaveFile, so the file on disk
+// is only replaced once all of it has been written; a failed or interrupted
+// save leaves the old file as it was. Whether it worked can be read once
+// the thread has finished.
+class INTELLISENSE_EXPORT SaveThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    SaveThread(const QString& fileName, const QString& text, QObject* parent = 0);
+
+    QString fileName() const;
+    bool succeeded() const;
+    QString errorString() const;
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    const QString mFileName;
+    const QString mSnapshot;
+    bool mSaved;
+    QString mError;
+};
+
+#endif // SAVETHREAD_H
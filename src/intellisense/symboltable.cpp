@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "symboltable.h"
+
+#include <QDebug>
+
+const SymbolId SymbolTable::NO_SYMBOL;
+
+SymbolTable::SymbolTable()
+{
+}
+
+SymbolTable* SymbolTable::instance()
+{
+    static SymbolTable table;
+    return &table;
+}
+
+SymbolId SymbolTable::intern(const QString& name)
+{
+    // Counting the use needs the write lock even when the name is known
+    QWriteLocker locker(&mLock);
+    QHash<QString, SymbolId>::const_iterator i = mIds.constFind(name);
+    if (i != mIds.constEnd()) {
+        ++mUses[i.value()];
+        return i.value();
+    }
+
+    SymbolId id;
+    if (!mFreeIds.isEmpty()) {
+        id = mFreeIds.back();
+        mFreeIds.pop_back();
+        mNames[id] = name;
+        mUses[id] = 1;
+    } else {
+        id = mNames.size();
+        mNames.push_back(name);
+        mUses.push_back(1);
+    }
+    mIds.insert(name, id);
+    return id;
+}
+
+void SymbolTable::release(SymbolId id)
+{
+    QWriteLocker locker(&mLock);
+    if (id < 0 || id >= mUses.size() || mUses[id] == 0) {
+        qDebug() << "Releasing unused symbol" << id;
+        return;
+    }
+
+    if (--mUses[id] == 0) {
+        mIds.remove(mNames[id]);
+        mNames[id] = QString();
+        mFreeIds.push_back(id);
+    }
+}
+
+SymbolId SymbolTable::find(const QString& name) const
+{
+    QReadLocker locker(&mLock);
+    return mIds.value(name, NO_SYMBOL);
+}
+
+QString SymbolTable::name(SymbolId id) const
+{
+    QReadLocker locker(&mLock);
+    if (id < 0 || id >= mNames.size())
+        return QString();
+    return mNames[id];
+}
+
+int SymbolTable::size() const
+{
+    QReadLocker locker(&mLock);
+    return mIds.size();
+}
@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+#include "intellisense_global.h"
+
+// The id of an interned identifier. Ids are small and dense, so they can be
+// hashed, compared and stored in place of the name.
+typedef int SymbolId;
+
+// Every distinct identifier the Intellisense library has seen, each with a
+// stable SymbolId.
+//
+// There is one table per process, shared by every document, so the same label
+// in two files has the same id and its name is stored once. Every intern() is a
+// use of the name that must be given back with release(); once the last use
+// goes the name is forgotten and its id can be handed to a new name. The table
+// therefore holds the names documents currently keep, not every partial
+// identifier ever typed. Interning can happen from any thread.
+class INTELLISENSE_EXPORT SymbolTable
+{
+public:
+    static const SymbolId NO_SYMBOL = -1;
+
+    static SymbolTable* instance();
+
+    // Returns the id of name, giving it a new one if it has none yet, and
+    // counts one more use of it
+    SymbolId intern(const QString& name);
+
+    // Gives back one use of id. The caller must not rely on id afterwards
+    void release(SymbolId id);
+
+    // Returns the id of name, or NO_SYMBOL if it was never interned. Use this
+    // for queries, so that looking up a name does not grow the table.
+    SymbolId find(const QString& name) const;
+
+    QString name(SymbolId id) const;
+    int size() const; // The number of names in use
+
+private:
+    SymbolTable();
+    Q_DISABLE_COPY(SymbolTable)
+
+    mutable QReadWriteLock mLock;
+    QHash<QString, SymbolId> mIds;
+    QVector<QString> mNames;
+    QVector<int> mUses;
+    QVector<SymbolId> mFreeIds;
+};
+
+#endif // SYMBOLTABLE_H
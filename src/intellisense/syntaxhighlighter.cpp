@@ -22,135 +22,405 @@
 
 #include "syntaxhighlighter.h"
 
+#include <QTextBlock>
+#include <QElapsedTimer>
+#include <QTextDocument>
+
+#include <algorithm> // std::sort, std::unique
+#include <climits> // INT_MAX
+
 #include "documentlabelindex.h"
+#include "tokenblockdata.h"
+
+namespace {
+
+// Answers from the label index as it is right now
+class IndexClassifier : public LabelClassifier
+{
+public:
+    explicit IndexClassifier(const DocumentLabelIndex* labelIndex) :
+        mLabelIndex(labelIndex)
+    {
+    }
+
+    HighlightFormat labelFormat(const QString& label, int line) const Q_DECL_OVERRIDE
+    {
+        // Utilize the DocumentLabelIndex to tell what kind of label this is. The
+        // name is looked up once; every question after that is asked by id
+        if (!mLabelIndex)
+            return NoFormat;
+        const SymbolId symbol = SymbolTable::instance()->find(label);
+        if (!mLabelIndex->hasLabel(symbol))
+            return BadLabelFormat;
+        if (mLabelIndex->hasLabelAtLine(symbol, line))
+            return mLabelIndex->isDuplicateLabel(symbol) ? DuplicateLabelFormat : LabelDeclarationFormat;
+        if (mLabelIndex->isFunctionLabel(symbol))
+            return FunctionLabelFormat;
+        if (mLabelIndex->isVariableLabel(symbol))
+            return VariableLabelFormat;
+        return NoFormat;
+    }
+
+private:
+    const DocumentLabelIndex* mLabelIndex;
+};
+
+}
 
 SyntaxHighlighter::SyntaxHighlighter(QTextDocument* parent, DocumentLabelIndex* labelIndex)
     : QSyntaxHighlighter(parent),
-      labelIndexer(labelIndex)
+      labelIndexer(labelIndex),
+      rehighlightScheduled(false),
+      numChangesSinceRehighlight(0),
+      lastChangeStart(0),
+      lastChangeEnd(0),
+      firstVisibleLine(0),
+      lastVisibleLine(INT_MAX),
+      highlightingPendingBlocks(false),
+      nextPendingLine(0),
+      numCleanBlocksSeen(0),
+      highlightJob(NULL),
+      highlightJobId(0),
+      highlightJobLabelGeneration(0),
+      labelGeneration(0),
+      labelKindsGeneration(-1),
+      precomputedRuns(NULL)
 {
-    HighlightingRule rule;
+    qRegisterMetaType<QVector<BlockFormats> >("QVector<BlockFormats>");
 
-    // Create a highlighting rule for numbers (decimal and hexidecimal)
-    numberFormat.setForeground(Qt::blue);
-    rule.pattern = QRegExp("\\b0x[0-9a-fA-F]+\\b|-[0-9]+\\b|\\b[0-9]+\\b");
-    //rule.pattern = Token::REGEX[Token::IntLiteral];
-    rule.format = numberFormat;
-    highlightingRules.append(rule);
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(0);
+    connect(&idleTimer, SIGNAL(timeout()), this, SLOT(highlightPendingBlocks()));
 
-    //labelExpression = QRegExp("^[A-Za-z]\\w*\\s");
-    labelExpression = Token::REGEX[Token::Label];
+    // Label declarations found by a background parse need their lines redrawn
+    if (labelIndexer) {
+        connect(labelIndexer, SIGNAL(linesParsed(int,int)), this, SLOT(onLinesParsed(int,int)));
+
+        // Every definition of a label changes look when it becomes (or stops being) a
+        // duplicate. Queued, so the edit that caused it has finished by the time we redraw
+        connect(labelIndexer, SIGNAL(duplicateStateChanged(QString,bool)), this,
+                SLOT(onDuplicateStateChanged(QString)), Qt::QueuedConnection);
+
+        // Uses of a label change look when the label is defined or removed
+        connect(labelIndexer, SIGNAL(labelAdded(QString,int)), this, SLOT(onLabelChanged(QString)));
+        connect(labelIndexer, SIGNAL(labelRemoved(QString,int)), this, SLOT(onLabelChanged(QString)));
+        connect(labelIndexer, SIGNAL(labelTypeChanged(QString,int)), this, SLOT(onLabelChanged(QString)));
+        connect(parent, SIGNAL(contentsChange(int,int,int)), this, SLOT(onContentsChange(int,int,int)));
+    }
+
+    // Create a highlighting format for numbers (decimal and hexidecimal)
+    formats[NumberFormat].setForeground(Qt::blue);
 
     // Create a highlighting format for E100 label declarations
-    labelDeclarationFormat.setForeground(Qt::darkRed);
-    labelDeclarationFormat.setFontItalic(true);
-    labelDeclarationFormat.setFontWeight(QFont::DemiBold);
+    formats[LabelDeclarationFormat].setForeground(Qt::darkRed);
+    formats[LabelDeclarationFormat].setFontItalic(true);
+    formats[LabelDeclarationFormat].setFontWeight(QFont::DemiBold);
 
     // Create a highlighting format for E100 labels that mark instructions
-    functionLabelFormat = labelDeclarationFormat;
+    formats[FunctionLabelFormat] = formats[LabelDeclarationFormat];
 
     // Create a highlighting format for E100 labels that are variables
-    variableLabelFormat.setFontItalic(false);
+    formats[VariableLabelFormat].setFontItalic(false);
 
     // Create a highlighting format for bad or erroneous E100 labels
-    badLabelFormat.setFontUnderline(true);
-    badLabelFormat.setUnderlineColor(Qt::red);
-    badLabelFormat.setUnderlineStyle(QTextCharFormat::NoUnderline);
-
-    // Create a highlighting rule for all the keywords (instructions)
-    keywordFormat.setForeground(Qt::darkBlue);
-    keywordFormat.setFontWeight(QFont::Bold);
-    rule.pattern = QRegExp(QString("\\b(%1)\\b").arg(Token::REGEX[Token::Instruction].pattern()));
-    rule.format = keywordFormat;
-    highlightingRules.append(rule);
-
-    // Create a highlighting rule for single-quoted characters
-    quotationFormat.setForeground(Qt::darkYellow);
-    rule.pattern = Token::REGEX[Token::CharLiteral];
-    rule.format = quotationFormat;
-    highlightingRules.append(rule);
-
-    // Create a highlighting rule for #include statements
-    includeFormat.setForeground(Qt::darkBlue);
-    rule.pattern = Token::REGEX[Token::Include];
-    rule.format = includeFormat;
-    highlightingRules.append(rule);
+    formats[BadLabelFormat].setFontUnderline(true);
+    formats[BadLabelFormat].setUnderlineColor(Qt::red);
+    formats[BadLabelFormat].setUnderlineStyle(QTextCharFormat::NoUnderline);
+
+    // Create a highlighting format for labels that are declared more than once
+    formats[DuplicateLabelFormat] = formats[LabelDeclarationFormat];
+    formats[DuplicateLabelFormat].setUnderlineColor(Qt::red);
+    formats[DuplicateLabelFormat].setUnderlineStyle(QTextCharFormat::WaveUnderline);
+
+    // Create a highlighting format for all the keywords (instructions)
+    formats[KeywordFormat].setForeground(Qt::darkBlue);
+    formats[KeywordFormat].setFontWeight(QFont::Bold);
+
+    // Create a highlighting format for single-quoted characters
+    formats[QuotationFormat].setForeground(Qt::darkYellow);
+
+    // Create a highlighting format for #include statements
+    formats[IncludeFormat].setForeground(Qt::darkBlue);
 
     // Now for included files
-    includeFileFormat.setForeground(Qt::darkYellow);
-    rule.pattern = Token::REGEX[Token::IncludeFile];
-    rule.format = includeFileFormat;
-    highlightingRules.append(rule);
+    formats[IncludeFileFormat].setForeground(Qt::darkYellow);
 
-    // Create a highlighting rule for single-line comments
-    singleLineCommentFormat.setForeground(Qt::darkGreen);
-    rule.pattern = Token::REGEX[Token::Comment];
-    rule.format = singleLineCommentFormat;
-    highlightingRules.append(rule);
+    // Create a highlighting format for single-line comments
+    formats[CommentFormat].setForeground(Qt::darkGreen);
+}
+
+SyntaxHighlighter::~SyntaxHighlighter()
+{
+    cancelHighlightJob();
 }
 
 void SyntaxHighlighter::highlightBlock(const QString& text)
 {
     const int currentLineNumber = currentBlock().blockNumber();
+
+    // Formats worked out by the highlight thread only need applying
+    if (precomputedRuns) {
+        TokenBlockData::setNeedsHighlight(currentBlock(), false);
+        applyRuns(*precomputedRuns);
+        return;
+    }
+
+    // Leave blocks out of sight for later. Returning without formatting
+    // leaves the block plain until then
+    if (!highlightingPendingBlocks && !isVisibleLine(currentLineNumber)) {
+        TokenBlockData::setNeedsHighlight(currentBlock(), true);
+        scheduleIdleHighlighting();
+        return;
+    }
+    TokenBlockData::setNeedsHighlight(currentBlock(), false);
     qDebug() << "highlighting line" << currentLineNumber;
 
-    // First, utilize the DocumentLabelIndex to highlight labels
-    int index = labelExpression.indexIn(text);
-    while (index >= 0) {
-        int length = labelExpression.matchedLength();
-        if (length == 0)
-            break;
-        QString matchedLabel = text.mid(index, length);
-        if (!isValidLabel(matchedLabel))
-            setFormat(index, length, badLabelFormat);
-        else if (isLabelDeclaration(matchedLabel, currentLineNumber))
-            setFormat(index, length, labelDeclarationFormat);
-        else if (isFunctionLabel(matchedLabel))
-            setFormat(index, length, functionLabelFormat);
-        else if (isVariableLabel(matchedLabel))
-            setFormat(index, length, variableLabelFormat);
-        index = labelExpression.indexIn(text, index + length);
+    // The tokenizer has usually lexed this block already and left its tokens on it
+    const TokenLine tokens = TokenBlockData::tokensOfBlock(currentBlock(), text);
+    applyRuns(LabelClassifier::formatRuns(tokens, currentLineNumber, IndexClassifier(labelIndexer)));
+}
+
+void SyntaxHighlighter::applyRuns(const FormatRuns& runs)
+{
+    foreach (const FormatRun& run, runs) {
+        setFormat(run.start, run.length, formats[run.format]);
+    }
+}
+
+bool SyntaxHighlighter::isVisibleLine(int line) const
+{
+    return line >= firstVisibleLine && line <= lastVisibleLine;
+}
+
+void SyntaxHighlighter::setVisibleLines(int firstLine, int lastLine)
+{
+    const int newFirst = qMax(0, firstLine - VISIBLE_MARGIN);
+    const int newLast = qMax(newFirst, lastLine) + VISIBLE_MARGIN;
+    if (newFirst == firstVisibleLine && newLast == lastVisibleLine)
+        return;
+    firstVisibleLine = newFirst;
+    lastVisibleLine = newLast;
+
+    // Scrolling into blocks that are still waiting highlights them now
+    QTextBlock block = document()->findBlockByNumber(firstVisibleLine);
+    for (int line = firstVisibleLine; line <= lastVisibleLine && block.isValid(); ++line) {
+        if (TokenBlockData::needsHighlight(block))
+            rehighlightBlock(block);
+        block = block.next();
     }
+}
+
+bool SyntaxHighlighter::hasPendingBlocks() const
+{
+    return idleTimer.isActive() || highlightJob;
+}
+
+QTextCharFormat SyntaxHighlighter::charFormat(HighlightFormat format) const
+{
+    return formats[format];
+}
 
-    // Then rehighlight using the other HighlightingRules
-    foreach (const HighlightingRule &rule, highlightingRules) {
-        QRegExp expression(rule.pattern);
-        int index = expression.indexIn(text);
-        while (index >= 0) {
-            int length = expression.matchedLength();
-            if (length == 0)
-                break;
-            setFormat(index, length, rule.format);
-            index = expression.indexIn(text, index + length);
+void SyntaxHighlighter::scheduleIdleHighlighting()
+{
+    numCleanBlocksSeen = 0;
+    if (!idleTimer.isActive())
+        idleTimer.start();
+}
+
+void SyntaxHighlighter::highlightPendingBlocks()
+{
+    // Work through waiting blocks for one slice, then go back to the event
+    // loop so input is never held up. We are done once we have gone all the
+    // way around the document without finding one
+    if (highlightJob)
+        return; // picked up again when the job finishes
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // With a label index the blocks are only copied out here, and formatted
+    // on a highlight thread
+    QVector<BlockSnapshot> snapshots;
+    const int numBlocks = document()->blockCount();
+    QTextBlock block = document()->findBlockByNumber(nextPendingLine);
+    highlightingPendingBlocks = true;
+    while (numCleanBlocksSeen < numBlocks && timer.elapsed() < IDLE_SLICE &&
+           snapshots.size() < MAX_JOB_SIZE) {
+        if (!block.isValid())
+            block = document()->begin();
+        if (TokenBlockData::needsHighlight(block)) {
+            if (labelIndexer) {
+                const int line = block.blockNumber();
+                BlockSnapshot snapshot = {line, block.revision(), TokenBlockData::tokensOfBlock(block),
+                                          labelIndexer->symbolAtLine(line)};
+                snapshots.push_back(snapshot);
+            } else {
+                rehighlightBlock(block);
+            }
+            numCleanBlocksSeen = 0;
+        } else {
+            ++numCleanBlocksSeen;
+        }
+        block = block.next();
+    }
+    highlightingPendingBlocks = false;
+    nextPendingLine = block.isValid() ? block.blockNumber() : 0;
+
+    if (!snapshots.isEmpty())
+        startHighlightJob(snapshots);
+    else if (numCleanBlocksSeen < numBlocks)
+        idleTimer.start();
+}
+
+void SyntaxHighlighter::startHighlightJob(const QVector<BlockSnapshot>& blocks)
+{
+    // The thread gets its own picture of the labels, refreshed only when
+    // they have changed since the last job
+    if (labelKindsGeneration != labelGeneration) {
+        labelKinds.clear();
+        foreach (SymbolId label, labelIndexer->labelSymbols()) {
+            int kind = 0;
+            if (labelIndexer->isFunctionLabel(label))
+                kind |= HighlightThread::Function;
+            if (labelIndexer->isDuplicateLabel(label))
+                kind |= HighlightThread::Duplicate;
+            labelKinds.insert(label, kind);
         }
+        labelKindsGeneration = labelGeneration;
     }
+
+    highlightJobId++;
+    highlightJobLabelGeneration = labelGeneration;
+    highlightJob = new HighlightThread(highlightJobId, blocks, labelKinds, this);
+    connect(highlightJob, SIGNAL(blocksFormatted(int,QVector<BlockFormats>)), this,
+            SLOT(onBlocksFormatted(int,QVector<BlockFormats>)));
+    connect(highlightJob, SIGNAL(finished()), this, SLOT(onHighlightJobFinished()));
+    highlightJob->start(QThread::LowPriority);
 }
 
-bool SyntaxHighlighter::isValidLabel(const QString& label) const
+void SyntaxHighlighter::cancelHighlightJob()
 {
-    qDebug() << "Checking for label:" << label;
-    if (!labelIndexer)
-        return true;
-    return labelIndexer->hasLabel(label);
+    if (!highlightJob)
+        return;
+
+    disconnect(highlightJob, 0, this, 0);
+    highlightJob->cancel();
+    highlightJob->wait();
+    delete highlightJob;
+    highlightJob = NULL;
 }
 
-bool SyntaxHighlighter::isLabelDeclaration(const QString& label, int line) const
+void SyntaxHighlighter::onBlocksFormatted(int jobId, const QVector<BlockFormats>& blocks)
 {
-    if (!labelIndexer)
-        return false;
-    return labelIndexer->lineNumberOfLabel(label) == line;
+    // Labels that changed since the snapshot may look different now. The
+    // blocks stay waiting and go out again with the next job
+    if (jobId != highlightJobId || highlightJobLabelGeneration != labelGeneration)
+        return;
+
+    QTextBlock block;
+    foreach (const BlockFormats& formats, blocks) {
+        block = (block.isValid() && block.blockNumber() + 1 == formats.line) ?
+                    block.next() : document()->findBlockByNumber(formats.line);
+        if (!block.isValid() || !TokenBlockData::needsHighlight(block))
+            continue;
+
+        // Lines above may have come or gone, so the text has to match too
+        if (block.revision() != formats.revision || block.text() != formats.text)
+            continue;
+
+        precomputedRuns = &formats.runs;
+        rehighlightBlock(block);
+        precomputedRuns = NULL;
+    }
 }
 
-bool SyntaxHighlighter::isFunctionLabel(const QString& label) const
+void SyntaxHighlighter::onHighlightJobFinished()
 {
-    if (!labelIndexer)
-        return false;
-    return labelIndexer->isFunctionLabel(label);
+    highlightJob->deleteLater();
+    highlightJob = NULL;
+
+    // Carry on with whatever is still waiting
+    if (numCleanBlocksSeen < document()->blockCount())
+        idleTimer.start();
 }
 
-bool SyntaxHighlighter::isVariableLabel(const QString& label) const
+void SyntaxHighlighter::onLinesParsed(int firstLine, int count)
 {
-    if (!labelIndexer)
-        return false;
-    return labelIndexer->isVariableLabel(label);
+    QTextBlock block = document()->findBlockByNumber(firstLine);
+    for (int i = 0; i < count && block.isValid(); ++i, block = block.next()) {
+        rehighlightBlock(block);
+    }
 }
 
+void SyntaxHighlighter::onDuplicateStateChanged(const QString& label)
+{
+    // Worker results still carry the old duplicate flag
+    ++labelGeneration;
+    foreach (int line, labelIndexer->definitionsOfLabel(label)) {
+        rehighlightBlock(document()->findBlockByNumber(line));
+    }
+}
+
+void SyntaxHighlighter::onLabelChanged(const QString& label)
+{
+    ++labelGeneration;
+    labelsToRehighlight.insert(label);
+    scheduleRehighlight();
+}
+
+void SyntaxHighlighter::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // QSyntaxHighlighter redraws the changed text itself, after the label
+    // index has seen the change, so those blocks are already up to date
+    Q_UNUSED(charsRemoved);
+    ++numChangesSinceRehighlight;
+    lastChangeStart = position;
+    lastChangeEnd = position + charsAdded;
+    scheduleRehighlight();
+}
+
+void SyntaxHighlighter::scheduleRehighlight()
+{
+    // Wait for the edit to finish, then redraw every use of every label it
+    // changed exactly once
+    if (!rehighlightScheduled) {
+        rehighlightScheduled = true;
+        QTimer::singleShot(0, this, SLOT(rehighlightChangedLabels()));
+    }
+}
+
+void SyntaxHighlighter::rehighlightChangedLabels()
+{
+    rehighlightScheduled = false;
+
+    QList<int> lines;
+    foreach (const QString& label, labelsToRehighlight) {
+        lines.append(labelIndexer->referencesOfLabel(label));
+    }
+    std::sort(lines.begin(), lines.end());
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+
+    // With more than one edit in between, the last one's range may have moved
+    const bool skipChangedText = (numChangesSinceRehighlight == 1);
+    const int changeStart = lastChangeStart;
+    const int changeEnd = lastChangeEnd;
+    labelsToRehighlight.clear();
+    numChangesSinceRehighlight = 0;
+
+    foreach (int line, lines) {
+        const QTextBlock block = document()->findBlockByNumber(line);
+        if (!block.isValid())
+            continue;
+        if (skipChangedText && block.position() <= changeEnd &&
+                block.position() + block.length() > changeStart)
+            continue;
+
+        // Uses out of sight keep their old look until the idle pass gets to them
+        if (isVisibleLine(line)) {
+            rehighlightBlock(block);
+        } else {
+            TokenBlockData::setNeedsHighlight(block, true);
+            scheduleIdleHighlighting();
+        }
+    }
+}
@@ -24,12 +24,17 @@
 #define SYNTAXHIGHLIGHTER_H
 
 #include <QMap>
+#include <QSet>
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
+#include <QTimer>
 
 #include "intellisense_global.h"
 
+#include "highlightthread.h"
+#include "symboltable.h"
 #include "token.h"
+#include "tokenline.h"
 
 QT_BEGIN_NAMESPACE
 class QTextDocument;
@@ -43,36 +48,71 @@ class INTELLISENSE_EXPORT SyntaxHighlighter : public QSyntaxHighlighter
 
 public:
     SyntaxHighlighter(QTextDocument* parent, DocumentLabelIndex* labelIndexer = 0);
+    virtual ~SyntaxHighlighter();
+
+    // Blocks near these lines are highlighted as soon as they change, and any
+    // left unhighlighted there are highlighted right away. The rest wait for
+    // idle time. By default every line counts as visible.
+    void setVisibleLines(int firstLine, int lastLine);
+    bool hasPendingBlocks() const;
+
+    // The character format text is drawn in for the given HighlightFormat
+    QTextCharFormat charFormat(HighlightFormat format) const;
 
 protected:
     void highlightBlock(const QString& text) Q_DECL_OVERRIDE;
 
+private slots:
+    void onLinesParsed(int firstLine, int count);
+    void onDuplicateStateChanged(const QString& label);
+    void onLabelChanged(const QString& label);
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void rehighlightChangedLabels();
+    void highlightPendingBlocks();
+    void onBlocksFormatted(int jobId, const QVector<BlockFormats>& blocks);
+    void onHighlightJobFinished();
+
 private:
-    struct HighlightingRule
-    {
-        QRegExp pattern;
-        QTextCharFormat format;
-    };
-    QVector<HighlightingRule> highlightingRules;
-
-    QTextCharFormat labelDeclarationFormat;
-    QTextCharFormat functionLabelFormat;
-    QTextCharFormat variableLabelFormat;
-    QTextCharFormat badLabelFormat;
-    QRegExp labelExpression;
+    static const int VISIBLE_MARGIN = 50;   // in lines
+    static const int IDLE_SLICE = 5;        // in milliseconds
+    static const int MAX_JOB_SIZE = 5000;   // in blocks
+
+    QTextCharFormat formats[NUM_FORMATS];
     DocumentLabelIndex* labelIndexer;
 
-    QTextCharFormat keywordFormat;
-    QTextCharFormat includeFormat;
-    QTextCharFormat includeFileFormat;
-    QTextCharFormat singleLineCommentFormat;
-    QTextCharFormat quotationFormat;
-    QTextCharFormat numberFormat;
-
-    bool isValidLabel(const QString& label) const;
-    bool isLabelDeclaration(const QString& label, int line) const;
-    bool isFunctionLabel(const QString& label) const;
-    bool isVariableLabel(const QString& label) const;
+    // Labels defined or removed since the last redraw of their uses
+    QSet<QString> labelsToRehighlight;
+    bool rehighlightScheduled;
+    int numChangesSinceRehighlight;
+    int lastChangeStart;
+    int lastChangeEnd;
+
+    // Off-screen blocks are marked in their TokenBlockData and highlighted a
+    // slice at a time by idleTimer, walking the document from nextPendingLine
+    int firstVisibleLine;
+    int lastVisibleLine;
+    bool highlightingPendingBlocks;
+    QTimer idleTimer;
+    int nextPendingLine;
+    int numCleanBlocksSeen;
+
+    // With a label index, the idle pass works out formats on a HighlightThread
+    // and only applies them here. labelGeneration counts label changes, so
+    // results worked out from an older picture of the labels are dropped
+    HighlightThread* highlightJob;
+    int highlightJobId;
+    int highlightJobLabelGeneration;
+    int labelGeneration;
+    HighlightThread::LabelKinds labelKinds;
+    int labelKindsGeneration;
+    const FormatRuns* precomputedRuns;
+
+    void scheduleRehighlight();
+    void scheduleIdleHighlighting();
+    bool isVisibleLine(int line) const;
+    void startHighlightJob(const QVector<BlockSnapshot>& blocks);
+    void cancelHighlightJob();
+    void applyRuns(const FormatRuns& runs);
 };
 
 #endif // SYNTAXHIGHLIGHTER_H
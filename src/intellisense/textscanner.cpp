@@ -0,0 +1,300 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "textscanner.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#  define TEXTSCANNER_X86
+#  include <immintrin.h>
+#endif
+
+namespace {
+
+typedef const ushort* (*SkipFunction)(const ushort*, const ushort*);
+typedef const ushort* (*FindFunction)(const ushort*, const ushort*, ushort);
+typedef int (*CountFunction)(const ushort*, const ushort*, ushort);
+
+struct Kernels
+{
+    SkipFunction skipAsciiSpaces;
+    SkipFunction findWordBreak;
+    FindFunction find;
+    CountFunction count;
+};
+
+inline bool isAsciiSpace(ushort u)
+{
+    return u == ' ' || ushort(u - '\t') <= '\r' - '\t';
+}
+
+inline bool isWordBreak(ushort u)
+{
+    return u >= 0x80 || u == '/' || isAsciiSpace(u);
+}
+
+// -- Scalar ----------------------------------------------------------------------------------------
+
+const ushort* skipAsciiSpacesScalar(const ushort* c, const ushort* end)
+{
+    while (c < end && isAsciiSpace(*c))
+        ++c;
+    return c;
+}
+
+const ushort* findWordBreakScalar(const ushort* c, const ushort* end)
+{
+    while (c < end && !isWordBreak(*c))
+        ++c;
+    return c;
+}
+
+const ushort* findScalar(const ushort* c, const ushort* end, ushort u)
+{
+    while (c < end && *c != u)
+        ++c;
+    return c;
+}
+
+int countScalar(const ushort* c, const ushort* end, ushort u)
+{
+    int n = 0;
+    for (; c < end; ++c) {
+        if (*c == u)
+            ++n;
+    }
+    return n;
+}
+
+#ifdef TEXTSCANNER_X86
+
+// Index of the first character flagged in a byte mask from movemask_epi8
+inline int firstFlagged(uint mask)
+{
+    return __builtin_ctz(mask) / 2;
+}
+
+// -- SSE2 (8 characters per step) ------------------------------------------------------------------
+
+inline __m128i asciiSpaceMask128(__m128i v)
+{
+    const __m128i isBlank = _mm_cmpeq_epi16(v, _mm_set1_epi16(' '));
+    // (v - '\t') <= 4, unsigned: saturating subtraction leaves zero
+    const __m128i shifted = _mm_sub_epi16(v, _mm_set1_epi16('\t'));
+    const __m128i isControl = _mm_cmpeq_epi16(_mm_subs_epu16(shifted, _mm_set1_epi16('\r' - '\t')),
+                                              _mm_setzero_si128());
+    return _mm_or_si128(isBlank, isControl);
+}
+
+const ushort* skipAsciiSpacesSSE2(const ushort* c, const ushort* end)
+{
+    for (; end - c >= 8; c += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c));
+        const uint notSpace = ~uint(_mm_movemask_epi8(asciiSpaceMask128(v))) & 0xFFFF;
+        if (notSpace)
+            return c + firstFlagged(notSpace);
+    }
+    return skipAsciiSpacesScalar(c, end);
+}
+
+const ushort* findWordBreakSSE2(const ushort* c, const ushort* end)
+{
+    for (; end - c >= 8; c += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c));
+        const __m128i isSlash = _mm_cmpeq_epi16(v, _mm_set1_epi16('/'));
+        const __m128i isAscii = _mm_cmpeq_epi16(_mm_subs_epu16(v, _mm_set1_epi16(0x7F)),
+                                                _mm_setzero_si128());
+        const __m128i isBreak = _mm_or_si128(_mm_or_si128(asciiSpaceMask128(v), isSlash),
+                                             _mm_andnot_si128(isAscii, _mm_set1_epi16(-1)));
+        const uint mask = _mm_movemask_epi8(isBreak);
+        if (mask)
+            return c + firstFlagged(mask);
+    }
+    return findWordBreakScalar(c, end);
+}
+
+const ushort* findSSE2(const ushort* c, const ushort* end, ushort u)
+{
+    const __m128i needle = _mm_set1_epi16(short(u));
+    for (; end - c >= 8; c += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c));
+        const uint mask = _mm_movemask_epi8(_mm_cmpeq_epi16(v, needle));
+        if (mask)
+            return c + firstFlagged(mask);
+    }
+    return findScalar(c, end, u);
+}
+
+int countSSE2(const ushort* c, const ushort* end, ushort u)
+{
+    const __m128i needle = _mm_set1_epi16(short(u));
+    int n = 0;
+    for (; end - c >= 8; c += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c));
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(v, needle))) / 2;
+    }
+    return n + countScalar(c, end, u);
+}
+
+// -- AVX2 (16 characters per step) -----------------------------------------------------------------
+
+#define TEXTSCANNER_AVX2 __attribute__((target("avx2")))
+
+TEXTSCANNER_AVX2 inline __m256i asciiSpaceMask256(__m256i v)
+{
+    const __m256i isBlank = _mm256_cmpeq_epi16(v, _mm256_set1_epi16(' '));
+    const __m256i shifted = _mm256_sub_epi16(v, _mm256_set1_epi16('\t'));
+    const __m256i isControl = _mm256_cmpeq_epi16(_mm256_subs_epu16(shifted, _mm256_set1_epi16('\r' - '\t')),
+                                                 _mm256_setzero_si256());
+    return _mm256_or_si256(isBlank, isControl);
+}
+
+TEXTSCANNER_AVX2 const ushort* skipAsciiSpacesAVX2(const ushort* c, const ushort* end)
+{
+    for (; end - c >= 16; c += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+        const uint notSpace = ~uint(_mm256_movemask_epi8(asciiSpaceMask256(v)));
+        if (notSpace)
+            return c + firstFlagged(notSpace);
+    }
+    return skipAsciiSpacesSSE2(c, end);
+}
+
+TEXTSCANNER_AVX2 const ushort* findWordBreakAVX2(const ushort* c, const ushort* end)
+{
+    for (; end - c >= 16; c += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+        const __m256i isSlash = _mm256_cmpeq_epi16(v, _mm256_set1_epi16('/'));
+        const __m256i isAscii = _mm256_cmpeq_epi16(_mm256_subs_epu16(v, _mm256_set1_epi16(0x7F)),
+                                                   _mm256_setzero_si256());
+        const __m256i isBreak = _mm256_or_si256(_mm256_or_si256(asciiSpaceMask256(v), isSlash),
+                                                _mm256_andnot_si256(isAscii, _mm256_set1_epi16(-1)));
+        const uint mask = _mm256_movemask_epi8(isBreak);
+        if (mask)
+            return c + firstFlagged(mask);
+    }
+    return findWordBreakSSE2(c, end);
+}
+
+TEXTSCANNER_AVX2 const ushort* findAVX2(const ushort* c, const ushort* end, ushort u)
+{
+    const __m256i needle = _mm256_set1_epi16(short(u));
+    for (; end - c >= 16; c += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+        const uint mask = _mm256_movemask_epi8(_mm256_cmpeq_epi16(v, needle));
+        if (mask)
+            return c + firstFlagged(mask);
+    }
+    return findSSE2(c, end, u);
+}
+
+TEXTSCANNER_AVX2 int countAVX2(const ushort* c, const ushort* end, ushort u)
+{
+    const __m256i needle = _mm256_set1_epi16(short(u));
+    int n = 0;
+    for (; end - c >= 16; c += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+        n += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, needle))) / 2;
+    }
+    return n + countSSE2(c, end, u);
+}
+
+#undef TEXTSCANNER_AVX2
+
+#endif // TEXTSCANNER_X86
+
+const Kernels KERNELS[TextScanner::NUM_KERNELS] = {
+    {skipAsciiSpacesScalar, findWordBreakScalar, findScalar, countScalar},
+#ifdef TEXTSCANNER_X86
+    {skipAsciiSpacesSSE2, findWordBreakSSE2, findSSE2, countSSE2},
+    {skipAsciiSpacesAVX2, findWordBreakAVX2, findAVX2, countAVX2}
+#else
+    {skipAsciiSpacesScalar, findWordBreakScalar, findScalar, countScalar},
+    {skipAsciiSpacesScalar, findWordBreakScalar, findScalar, countScalar}
+#endif
+};
+
+TextScanner::Kernel bestKernel()
+{
+#ifdef TEXTSCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return TextScanner::AVX2;
+    return TextScanner::SSE2;
+#else
+    return TextScanner::Scalar;
+#endif
+}
+
+// The kernel in use; chosen on first use, or set explicitly for tests
+TextScanner::Kernel& currentKernel()
+{
+    static TextScanner::Kernel kernel = bestKernel();
+    return kernel;
+}
+
+inline const ushort* utf16(const QChar* c)
+{
+    return reinterpret_cast<const ushort*>(c);
+}
+
+inline const QChar* qchars(const ushort* u)
+{
+    return reinterpret_cast<const QChar*>(u);
+}
+
+} // namespace
+
+TextScanner::Kernel TextScanner::kernel()
+{
+    return currentKernel();
+}
+
+bool TextScanner::isKernelSupported(Kernel kernel)
+{
+    return kernel >= Scalar && kernel <= bestKernel();
+}
+
+void TextScanner::setKernel(Kernel kernel)
+{
+    Q_ASSERT(isKernelSupported(kernel));
+    currentKernel() = kernel;
+}
+
+const QChar* TextScanner::skipAsciiSpaces(const QChar* begin, const QChar* end)
+{
+    return qchars(KERNELS[currentKernel()].skipAsciiSpaces(utf16(begin), utf16(end)));
+}
+
+const QChar* TextScanner::findWordBreak(const QChar* begin, const QChar* end)
+{
+    return qchars(KERNELS[currentKernel()].findWordBreak(utf16(begin), utf16(end)));
+}
+
+const QChar* TextScanner::find(const QChar* begin, const QChar* end, QChar c)
+{
+    return qchars(KERNELS[currentKernel()].find(utf16(begin), utf16(end), c.unicode()));
+}
+
+int TextScanner::count(const QChar* begin, const QChar* end, QChar c)
+{
+    return KERNELS[currentKernel()].count(utf16(begin), utf16(end), c.unicode());
+}
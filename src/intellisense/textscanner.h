@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTSCANNER_H
+#define TEXTSCANNER_H
+
+#include <QChar>
+
+#include "intellisense_global.h"
+
+// Fast scanning primitives over UTF-16 text.
+//
+// Each primitive has a scalar version and, on x86, SSE2 and AVX2 versions that
+// look at 8 or 16 characters per step. The fastest kernel the CPU supports is
+// picked the first time a primitive is used. Only ASCII is classified by the
+// vector kernels: any non-ASCII character stops a scan so that the caller can
+// classify it with QChar.
+class INTELLISENSE_EXPORT TextScanner
+{
+public:
+    enum Kernel
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+        NUM_KERNELS
+    };
+
+    static Kernel kernel();
+    static bool isKernelSupported(Kernel kernel);
+    static void setKernel(Kernel kernel);
+
+    // First character that is not an ASCII space (' ', '\t' to '\r'), or end
+    static const QChar* skipAsciiSpaces(const QChar* begin, const QChar* end);
+
+    // First ASCII space, '/' or non-ASCII character, or end
+    static const QChar* findWordBreak(const QChar* begin, const QChar* end);
+
+    // First occurrence of c, or end
+    static const QChar* find(const QChar* begin, const QChar* end, QChar c);
+
+    static int count(const QChar* begin, const QChar* end, QChar c);
+};
+
+#endif // TEXTSCANNER_H
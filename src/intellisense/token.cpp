@@ -26,7 +26,7 @@ const QRegExp Token::REGEX[Token::NUM_TOKEN_TYPES - 1] = {
     QRegExp("//[^\n]*"),            // Comment
     QRegExp("halt|add|sub|mult|div|cp|and|or|not|"
             "sl|sr|cpfa|cpta|be|bne|blt|call|ret",
-            Qt::CaseInsensitive),   // Instruction
+            Qt::CaseInsensitive),   // Instruction (reference only; see MnemonicTable)
     QRegExp("#include"),            // Include
     QRegExp("[\\./\\w]+\\.e"),      // IncludeFile
     QRegExp("[A-Za-z]\\w*"),        // Label
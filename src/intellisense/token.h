@@ -25,6 +25,7 @@
 
 #include <QDebug>
 #include <QHash>
+#include <QList>
 #include <QMetaType>
 #include <QRegExp>
 #include <QString>
@@ -57,6 +58,8 @@ struct Token
 
 Q_DECLARE_METATYPE(Token)
 
+typedef QList<Token> TokenList;
+
 inline bool operator==(const Token& a, const Token& b)
 {
     return a.value == b.value &&
@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "tokenblockdata.h"
+
+#include "linelexer.h"
+
+namespace {
+
+// Block revisions are never negative, so data stamped with this is never used
+// as a token cache
+const int NO_REVISION = -1;
+
+}
+
+TokenBlockData::TokenBlockData(const TokenLine& tokens, int revision) :
+    mTokens(tokens),
+    mRevision(revision),
+    mNeedsHighlight(false)
+{
+}
+
+TokenLine TokenBlockData::tokensOfBlock(QTextBlock block)
+{
+    return tokensOfBlock(block, block.text());
+}
+
+TokenLine TokenBlockData::tokensOfBlock(QTextBlock block, const QString& text)
+{
+    const TokenBlockData* data = cachedData(block, text);
+    if (data)
+        return data->tokens();
+
+    TokenLine tokens = LineLexer::tokenize(text);
+    store(block, tokens);
+    return tokens;
+}
+
+const TokenBlockData* TokenBlockData::cachedData(const QTextBlock& block, const QString& text)
+{
+    // Only DocumentTokenizer and SyntaxHighlighter set block user data
+    const TokenBlockData* data = static_cast<const TokenBlockData*>(block.userData());
+    if (!data || data->revision() != block.revision())
+        return NULL;
+
+    // Undo can put an old revision number back on a block, so check the text too
+    if (data->tokens().text() != text)
+        return NULL;
+
+    return data;
+}
+
+void TokenBlockData::store(QTextBlock block, const TokenLine& tokens)
+{
+    if (block.isValid()) {
+        TokenBlockData* data = new TokenBlockData(tokens, block.revision());
+        data->mNeedsHighlight = needsHighlight(block);
+        block.setUserData(data);
+    }
+}
+
+bool TokenBlockData::needsHighlight(const QTextBlock& block)
+{
+    const TokenBlockData* data = static_cast<const TokenBlockData*>(block.userData());
+    return data && data->mNeedsHighlight;
+}
+
+void TokenBlockData::setNeedsHighlight(QTextBlock block, bool needsHighlight)
+{
+    if (!block.isValid())
+        return;
+
+    TokenBlockData* data = static_cast<TokenBlockData*>(block.userData());
+    if (!data) {
+        if (!needsHighlight)
+            return;
+        data = new TokenBlockData(TokenLine(), NO_REVISION);
+        block.setUserData(data);
+    }
+    data->mNeedsHighlight = needsHighlight;
+}
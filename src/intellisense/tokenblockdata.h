@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TOKENBLOCKDATA_H
+#define TOKENBLOCKDATA_H
+
+#include <QTextBlock>
+#include <QTextBlockUserData>
+
+#include "intellisense_global.h"
+#include "tokenline.h"
+
+// The tokens of a QTextBlock, cached on the block itself.
+//
+// Whoever lexes a block first (the DocumentTokenizer or the SyntaxHighlighter)
+// stores the result here, and the other reuses it. The cache is stamped with the
+// block's revision and holds the text it was made from, so a stale cache is
+// never used.
+//
+// The block data also remembers whether the SyntaxHighlighter has put off
+// highlighting the block, so that the mark survives the tokens being replaced.
+class INTELLISENSE_EXPORT TokenBlockData : public QTextBlockUserData
+{
+public:
+    TokenBlockData(const TokenLine& tokens, int revision);
+
+    const TokenLine& tokens() const;
+    int revision() const;
+
+    // The tokens of the block, lexing it only if its cache is missing or stale.
+    // The text must be the block's current text.
+    static TokenLine tokensOfBlock(QTextBlock block);
+    static TokenLine tokensOfBlock(QTextBlock block, const QString& text);
+
+    static const TokenBlockData* cachedData(const QTextBlock& block, const QString& text);
+    static void store(QTextBlock block, const TokenLine& tokens);
+
+    static bool needsHighlight(const QTextBlock& block);
+    static void setNeedsHighlight(QTextBlock block, bool needsHighlight);
+
+private:
+    TokenLine mTokens;
+    int mRevision;
+    bool mNeedsHighlight;
+};
+
+inline const TokenLine& TokenBlockData::tokens() const
+{
+    return mTokens;
+}
+
+inline int TokenBlockData::revision() const
+{
+    return mRevision;
+}
+
+#endif // TOKENBLOCKDATA_H
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "tokenizerthread.h"
+
+#include "linelexer.h"
+#include "textscanner.h"
+
+TokenizerThread::TokenizerThread(int jobId, const QString& text, QObject* parent) :
+    QThread(parent),
+    mJobId(jobId),
+    mText(text),
+    mCancelled(0)
+{
+}
+
+int TokenizerThread::jobId() const
+{
+    return mJobId;
+}
+
+void TokenizerThread::cancel()
+{
+    mCancelled.store(1);
+}
+
+void TokenizerThread::run()
+{
+    QVector<TokenLine> chunk;
+    chunk.reserve(CHUNK_SIZE);
+    int firstLineOfChunk = 0;
+
+    const QChar* const begin = mText.constData();
+    const QChar* const end = begin + mText.length();
+    const QChar* lineStart = begin;
+    while (lineStart <= end) {
+        if (mCancelled.load())
+            return;
+
+        const QChar* lineEnd = TextScanner::find(lineStart, end, QChar::ParagraphSeparator);
+
+        chunk.push_back(LineLexer::tokenize(QString(lineStart, static_cast<int>(lineEnd - lineStart))));
+        lineStart = lineEnd + 1;
+
+        if (chunk.size() == CHUNK_SIZE) {
+            emit linesTokenized(mJobId, firstLineOfChunk, chunk);
+            firstLineOfChunk += chunk.size();
+            chunk.clear();
+            chunk.reserve(CHUNK_SIZE);
+        }
+    }
+
+    if (!chunk.isEmpty() && !mCancelled.load())
+        emit linesTokenized(mJobId, firstLineOfChunk, chunk);
+}
@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TOKENIZERTHREAD_H
+#define TOKENIZERTHREAD_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+#include "intellisense_global.h"
+#include "tokenline.h"
+
+// Tokenizes a snapshot of some lines of a document off the GUI thread.
+//
+// The text is the lines joined by QChar::ParagraphSeparator, as returned by
+// QTextCursor::selectedText(). Lines are lexed in chunks and each finished chunk
+// is handed back through linesTokenized(), numbered from the first line of the
+// snapshot. The thread never touches the document itself.
+class INTELLISENSE_EXPORT TokenizerThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    static const int CHUNK_SIZE = 1000;
+
+    TokenizerThread(int jobId, const QString& text, QObject* parent = 0);
+
+    int jobId() const;
+    void cancel();
+
+signals:
+    void linesTokenized(int jobId, int firstLine, const QVector<TokenLine>& lines);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    const int mJobId;
+    const QString mText;
+    QAtomicInt mCancelled;
+};
+
+#endif // TOKENIZERTHREAD_H
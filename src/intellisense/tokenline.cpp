@@ -0,0 +1,178 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "tokenline.h"
+
+static const QString NEWLINE_TEXT("\n");
+
+// Above this many cells the LCS table is not worth it, and the differing middle
+// of the two lines is reported as a single edit
+static const int MAX_LCS_CELLS = 64 * 64;
+
+static uint hashOfToken(const TokenLine& line, int i)
+{
+    return qHash(line.valueAt(i)) ^ line.typeAt(i);
+}
+
+TokenLine::TokenLine()
+{
+}
+
+TokenLine::TokenLine(const QString& text) :
+    mText(text)
+{
+}
+
+QStringRef TokenLine::valueAt(int i) const
+{
+    const TokenSpan& span = mSpans.at(i);
+    if (span.type == Token::Newline)
+        return QStringRef(&NEWLINE_TEXT);
+    return QStringRef(&mText, span.column, span.length);
+}
+
+Token TokenLine::tokenAt(int i) const
+{
+    Token token = {valueAt(i).toString(), typeAt(i)};
+    return token;
+}
+
+TokenList TokenLine::toList() const
+{
+    TokenList tokens;
+    tokens.reserve(size());
+    for (int i = 0; i < size(); ++i) {
+        tokens.push_back(tokenAt(i));
+    }
+    return tokens;
+}
+
+bool TokenLine::sameTokenAt(int i, const TokenLine& other, int j) const
+{
+    return typeAt(i) == other.typeAt(j) && valueAt(i) == other.valueAt(j);
+}
+
+TokenLineDiff TokenLine::diff(const TokenLine& from, const TokenLine& to)
+{
+    TokenLineDiff edits;
+
+    // Most edits touch one spot, so first skip the tokens both lines start and end with
+    int prefix = 0;
+    while (prefix < from.size() && prefix < to.size() && from.sameTokenAt(prefix, to, prefix))
+        ++prefix;
+
+    int suffix = 0;
+    while (suffix < from.size() - prefix && suffix < to.size() - prefix &&
+           from.sameTokenAt(from.size() - 1 - suffix, to, to.size() - 1 - suffix))
+        ++suffix;
+
+    const int n = from.size() - prefix - suffix;
+    const int m = to.size() - prefix - suffix;
+    if (n == 0 && m == 0)
+        return edits;
+
+    if (n == 0 || m == 0 || n * m > MAX_LCS_CELLS) {
+        TokenEdit edit = {prefix, n, prefix, m};
+        edits.push_back(edit);
+        return edits;
+    }
+
+    // Longest common subsequence of the middles, comparing hashes first.
+    // lengths[i * (m + 1) + j] is the LCS length of from[i..] and to[j..]
+    QVector<uint> fromHashes(n);
+    for (int i = 0; i < n; ++i) {
+        fromHashes[i] = hashOfToken(from, prefix + i);
+    }
+    QVector<uint> toHashes(m);
+    for (int j = 0; j < m; ++j) {
+        toHashes[j] = hashOfToken(to, prefix + j);
+    }
+
+    const int width = m + 1;
+    QVector<int> lengths((n + 1) * width, 0);
+    QVector<bool> matches(n * m, false);
+    for (int i = n - 1; i >= 0; --i) {
+        for (int j = m - 1; j >= 0; --j) {
+            const bool match = fromHashes[i] == toHashes[j] &&
+                    from.sameTokenAt(prefix + i, to, prefix + j);
+            matches[i * m + j] = match;
+            lengths[i * width + j] = match ?
+                        lengths[(i + 1) * width + j + 1] + 1 :
+                        qMax(lengths[(i + 1) * width + j], lengths[i * width + j + 1]);
+        }
+    }
+
+    // Walk the table, gathering consecutive non-matching tokens into edits
+    TokenEdit edit = {0, 0, 0, 0};
+    int i = 0;
+    int j = 0;
+    while (i < n || j < m) {
+        if (i < n && j < m && matches[i * m + j]) {
+            if (edit.oldCount > 0 || edit.newCount > 0) {
+                edits.push_back(edit);
+                edit.oldCount = edit.newCount = 0;
+            }
+            ++i;
+            ++j;
+            continue;
+        }
+
+        if (edit.oldCount == 0 && edit.newCount == 0) {
+            edit.oldIndex = prefix + i;
+            edit.newIndex = prefix + j;
+        }
+
+        if (j < m && (i == n || lengths[i * width + j + 1] >= lengths[(i + 1) * width + j])) {
+            ++edit.newCount;
+            ++j;
+        } else {
+            ++edit.oldCount;
+            ++i;
+        }
+    }
+    if (edit.oldCount > 0 || edit.newCount > 0)
+        edits.push_back(edit);
+
+    return edits;
+}
+
+void TokenLine::append(Token::TokenType type, int column, int length)
+{
+    TokenSpan span = {column, length, type};
+    mSpans.push_back(span);
+}
+
+void TokenLine::appendNewline()
+{
+    append(Token::Newline, mText.length(), 1);
+}
+
+bool TokenLine::endsWithNewline() const
+{
+    return !mSpans.isEmpty() && mSpans.last().type == Token::Newline;
+}
+
+void TokenLine::removeTrailingNewline()
+{
+    if (endsWithNewline())
+        mSpans.pop_back();
+}
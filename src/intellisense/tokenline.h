@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TOKENLINE_H
+#define TOKENLINE_H
+
+#include <QMetaType>
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+
+#include "intellisense_global.h"
+#include "token.h"
+
+// A compact token record. It does not own any text; column and length refer to
+// the text of the TokenLine that holds it.
+struct TokenSpan
+{
+    int column;
+    int length;
+    Token::TokenType type;
+};
+
+Q_DECLARE_TYPEINFO(TokenSpan, Q_PRIMITIVE_TYPE);
+
+// One run of tokens that differs between two versions of a line: the oldCount
+// tokens starting at oldIndex in the old line were replaced by the newCount
+// tokens starting at newIndex in the new line. Either count may be zero.
+struct TokenEdit
+{
+    int oldIndex;
+    int oldCount;
+    int newIndex;
+    int newCount;
+};
+
+Q_DECLARE_TYPEINFO(TokenEdit, Q_PRIMITIVE_TYPE);
+
+typedef QVector<TokenEdit> TokenLineDiff;
+
+// The tokens of one line of a document.
+//
+// A TokenLine keeps the (implicitly shared) text of the line and one TokenSpan
+// per token, so storing a line costs two allocations no matter how many tokens
+// it has. Token values are handed out as QStringRefs into the line's text and
+// are only turned into QStrings when a caller explicitly asks for a Token.
+// The Newline token has no characters in the text; its value is always "\n".
+class INTELLISENSE_EXPORT TokenLine
+{
+public:
+    TokenLine();
+    explicit TokenLine(const QString& text);
+
+    const QString& text() const;
+    const QVector<TokenSpan>& spans() const;
+
+    int size() const;
+    bool isEmpty() const;
+
+    const TokenSpan& at(int i) const;
+    Token::TokenType typeAt(int i) const;
+    QStringRef valueAt(int i) const;
+    Token tokenAt(int i) const;
+    TokenList toList() const;
+
+    bool sameTokenAt(int i, const TokenLine& other, int j) const;
+    static TokenLineDiff diff(const TokenLine& from, const TokenLine& to);
+
+    void append(Token::TokenType type, int column, int length);
+    void appendNewline();
+    bool endsWithNewline() const;
+    void removeTrailingNewline();
+
+private:
+    QString mText;
+    QVector<TokenSpan> mSpans;
+};
+
+inline const QString& TokenLine::text() const
+{
+    return mText;
+}
+
+inline const QVector<TokenSpan>& TokenLine::spans() const
+{
+    return mSpans;
+}
+
+inline int TokenLine::size() const
+{
+    return mSpans.size();
+}
+
+inline bool TokenLine::isEmpty() const
+{
+    return mSpans.isEmpty();
+}
+
+inline const TokenSpan& TokenLine::at(int i) const
+{
+    return mSpans.at(i);
+}
+
+inline Token::TokenType TokenLine::typeAt(int i) const
+{
+    return mSpans.at(i).type;
+}
+
+Q_DECLARE_METATYPE(TokenLine)
+
+#endif // TOKENLINE_H
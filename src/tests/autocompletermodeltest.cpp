@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "autocompletermodeltest.h"
+
+#include <QSignalSpy>
+#include <QTest>
+#include <QTextCursor>
+#include <QTextDocument>
+
+#include <autocompletermodel.h>
+#include <documentlabelindex.h>
+
+namespace {
+
+bool isSorted(const AutocompleterModel& model)
+{
+    for (int i = 1; i < model.rowCount(); ++i) {
+        const QString previous = model.index(i - 1).data().toString();
+        const QString current = model.index(i).data().toString();
+        if (QString::compare(previous, current, Qt::CaseInsensitive) > 0)
+            return false;
+    }
+    return true;
+}
+
+}
+
+void AutocompleterModelTest::testCompletions()
+{
+    QTextDocument doc("Loop\tadd\ta\tb\tc\n"
+                      "low\t0\n"
+                      "a\t0\n"
+                      "b\t0\n"
+                      "c\t0");
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel model(&index);
+
+    QVERIFY(isSorted(model));
+    QCOMPARE(model.completions("lo"), QStringList({"Loop", "low"}));
+    QCOMPARE(model.completions("LOO"), QStringList({"Loop"}));
+    QCOMPARE(model.completions("cp"), QStringList({"cp", "cpfa", "cpta"}));
+    QCOMPARE(model.completions("#inc"), QStringList({"#include"}));
+    QCOMPARE(model.numCompletions("x"), 0);
+
+    // The matches for a prefix are a single run of rows
+    const int first = model.firstCompletion("b");
+    QCOMPARE(model.index(first).data().toString(), QString("b"));
+    QCOMPARE(model.numCompletions("b"), 4); // b, be, blt, bne
+}
+
+void AutocompleterModelTest::testIncrementalUpdates()
+{
+    QTextDocument doc("a\t0\n"
+                      "c\t0");
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel model(&index);
+
+    QSignalSpy insertSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removeSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    const int initialRows = model.rowCount();
+
+    // Adding a label inserts one row in its sorted place
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("\nbb\t0");
+    QCOMPARE(model.rowCount(), initialRows + 1);
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(model.completions("bb"), QStringList({"bb"}));
+    QVERIFY(isSorted(model));
+
+    // A second definition does not add another row
+    cursor.insertText("\nbb\t1");
+    QCOMPARE(model.rowCount(), initialRows + 1);
+
+    // The row stays until the last definition goes
+    cursor.movePosition(QTextCursor::StartOfBlock, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QCOMPARE(model.rowCount(), initialRows + 1);
+    cursor.movePosition(QTextCursor::PreviousCharacter);
+    cursor.movePosition(QTextCursor::StartOfBlock, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QCOMPARE(model.rowCount(), initialRows);
+    QCOMPARE(removeSpy.count(), 1);
+    QVERIFY(model.completions("bb").isEmpty());
+
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void AutocompleterModelTest::benchmarkCompletions()
+{
+    // 20k labels sharing a handful of prefixes
+    const int numLabels = 20000;
+    QString docText;
+    for (int i = 0; i < numLabels; ++i) {
+        docText.append(QString("label%1\t0\n").arg(i));
+    }
+
+    QTextDocument doc(docText);
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel model(&index);
+    QVERIFY(isSorted(model));
+
+    int count = 0;
+    QBENCHMARK {
+        count = model.numCompletions("label1999");
+    }
+    QCOMPARE(count, 11); // label1999 and label19990 to label19999
+}
@@ -0,0 +1,219 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "completionenginetest.h"
+
+#include <QPersistentModelIndex>
+#include <QSignalSpy>
+#include <QTest>
+#include <QTextCursor>
+#include <QTextDocument>
+
+#include <autocompletermodel.h>
+#include <completionengine.h>
+#include <documentlabelindex.h>
+
+void CompletionEngineTest::testMatchScore_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QString>("candidate");
+    QTest::addColumn<bool>("matches");
+
+    QTest::newRow("prefix") << "loop" << "loop_counter" << true;
+    QTest::newRow("subsequence") << "lpctr" << "loop_counter" << true;
+    QTest::newRow("ignores case") << "LPC" << "loopCounter" << true;
+    QTest::newRow("out of order") << "ctrlp" << "loop_counter" << false;
+    QTest::newRow("missing character") << "lpx" << "loop_counter" << false;
+    QTest::newRow("longer than candidate") << "adds" << "add" << false;
+    QTest::newRow("empty pattern") << "" << "add" << true;
+}
+
+void CompletionEngineTest::testMatchScore()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QString, candidate);
+    QFETCH(bool, matches);
+
+    QCOMPARE(CompletionEngine::matchScore(pattern, candidate) >= 0, matches);
+}
+
+void CompletionEngineTest::testRanking()
+{
+    // Word boundaries and runs beat scattered matches
+    QVERIFY(CompletionEngine::matchScore("lc", "loop_counter") >
+            CompletionEngine::matchScore("lc", "lilac"));
+    QVERIFY(CompletionEngine::matchScore("loo", "loop") >
+            CompletionEngine::matchScore("loo", "lo_o"));
+    QVERIFY(CompletionEngine::matchScore("add", "add") >
+            CompletionEngine::matchScore("add", "adder"));
+
+    // Two labels that match equally well: one used often, one defined right
+    // next to the cursor
+    QTextDocument doc("count_a\t0\n"
+                      "\tcp\tcount_a\tcount_a\n"
+                      "\tcp\tcount_a\tcount_a\n"
+                      "\tcp\tcount_a\tcount_a\n"
+                      "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n"
+                      "count_b\t0");
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel candidates(&index);
+    CompletionEngine engine(&candidates);
+
+    engine.setPattern("cnt");
+    QCOMPARE(engine.completionAt(0), QString("count_a"));
+
+    engine.setPattern("cnt", doc.blockCount() - 1);
+    QCOMPARE(engine.completionAt(0), QString("count_b"));
+    QCOMPARE(engine.rowCount(), 2);
+}
+
+void CompletionEngineTest::testNarrowing()
+{
+    QString docText;
+    for (int i = 0; i < 1000; ++i) {
+        docText.append(QString("%1%2\t0\n").arg(i % 2 ? "loop" : "end").arg(i));
+    }
+    QTextDocument doc(docText);
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel candidates(&index);
+    CompletionEngine engine(&candidates);
+    engine.setTimeBudget(1000000);
+
+    engine.setPattern("lo");
+    QVERIFY(engine.isComplete());
+    QCOMPARE(engine.numScannedLastPass(), candidates.rowCount());
+    const int matchesOfLo = engine.numMatches();
+    QVERIFY(matchesOfLo >= 500);
+
+    // Typing another character only looks at what matched before
+    engine.setPattern("loo");
+    QCOMPARE(engine.numScannedLastPass(), matchesOfLo);
+    QCOMPARE(engine.numMatches(), 500);
+    QCOMPARE(engine.rowCount(), int(CompletionEngine::MAX_RESULTS));
+
+    // Backspacing starts over
+    engine.setPattern("l");
+    QCOMPARE(engine.numScannedLastPass(), candidates.rowCount());
+
+    // So does a change to the candidates
+    engine.setPattern("lo");
+    QTextCursor cursor(&doc);
+    cursor.insertText("loop_new\t0\n");
+    engine.setPattern("loo");
+    QCOMPARE(engine.numScannedLastPass(), candidates.rowCount());
+    QCOMPARE(engine.numMatches(), 501);
+}
+
+void CompletionEngineTest::testTimeBudget()
+{
+    QString docText;
+    for (int i = 0; i < 5000; ++i) {
+        docText.append(QString("label%1\t0\n").arg(i));
+    }
+    QTextDocument doc(docText);
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel candidates(&index);
+    CompletionEngine engine(&candidates);
+
+    // With no time at all, one slice is matched now and the rest later
+    engine.setTimeBudget(0);
+    QSignalSpy changedSpy(&engine, SIGNAL(completionsChanged()));
+    engine.setPattern("lbl");
+    QVERIFY(!engine.isComplete());
+    QVERIFY(engine.numScannedLastPass() < candidates.rowCount());
+    QCOMPARE(changedSpy.count(), 1);
+
+    QTRY_VERIFY(engine.isComplete());
+    QCOMPARE(engine.numMatches(), 5000);
+    QVERIFY(changedSpy.count() > 1);
+}
+
+void CompletionEngineTest::testIncrementalResults()
+{
+    // The best match sorts after everything else, so it turns up in a late slice
+    QString docText;
+    for (int i = 0; i < 5000; ++i) {
+        docText.append(QString("label%1\t0\n").arg(i));
+    }
+    docText.append("lbl\t0");
+    QTextDocument doc(docText);
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel candidates(&index);
+    CompletionEngine engine(&candidates);
+
+    engine.setTimeBudget(0);
+    engine.setPattern("lbl");
+    QVERIFY(!engine.isComplete());
+    QVERIFY(engine.rowCount() > 0);
+
+    const QString firstBest = engine.completionAt(0);
+    const QPersistentModelIndex firstBestIndex = engine.index(0, 0);
+
+    // Later slices change rows one at a time instead of resetting the model
+    QSignalSpy resetSpy(&engine, SIGNAL(modelReset()));
+    QTRY_VERIFY(engine.isComplete());
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(engine.completionAt(0), QString("lbl"));
+
+    // A row that is still in the results is still the same row to a view
+    if (engine.indexOfCompletion(firstBest) >= 0) {
+        QVERIFY(firstBestIndex.isValid());
+        QCOMPARE(firstBestIndex.data().toString(), firstBest);
+        QCOMPARE(firstBestIndex.row(), engine.indexOfCompletion(firstBest));
+    } else {
+        QVERIFY(!firstBestIndex.isValid());
+    }
+
+    // and the results end up the same as matching everything at once
+    CompletionEngine expected(&candidates);
+    expected.setTimeBudget(1000000);
+    expected.setPattern("lbl");
+    QCOMPARE(engine.rowCount(), expected.rowCount());
+    for (int row = 0; row < expected.rowCount(); ++row) {
+        QCOMPARE(engine.completionAt(row), expected.completionAt(row));
+    }
+}
+
+void CompletionEngineTest::benchmarkKeystroke()
+{
+    // 20k labels, then a word typed one character at a time
+    QString docText;
+    for (int i = 0; i < 20000; ++i) {
+        docText.append(QString("loop_counter%1\t0\n").arg(i));
+    }
+    QTextDocument doc(docText);
+    DocumentLabelIndex index(&doc);
+    AutocompleterModel candidates(&index);
+    CompletionEngine engine(&candidates);
+    engine.setTimeBudget(1000000);
+
+    QBENCHMARK {
+        engine.setPattern("l");
+        engine.setPattern("lp");
+        engine.setPattern("lpc");
+        engine.setPattern("lpct");
+        engine.setPattern("lpctr");
+        engine.setPattern("lpctr1");
+    }
+    QVERIFY(engine.isComplete());
+    QCOMPARE(engine.completionAt(0), QString("loop_counter1"));
+}
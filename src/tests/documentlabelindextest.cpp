@@ -153,6 +153,20 @@ void DocumentLabelIndexTest::testSignals_data()
                                                        {"label3", 2}
                                                    });
 
+    QTest::newRow("remove repeated label") << "loop\tbne\tloop\tx" <<
+                                              13 << 15 << "" <<
+                                              ParamList() <<
+                                              ParamList();
+
+    QTest::newRow("remove token before label") << "x loop\t0" <<
+                                                  0 << 2 << "" <<
+                                                  ParamList({
+                                                                {"loop", 0}
+                                                            }) <<
+                                                  ParamList({
+                                                                {"x", 0}
+                                                            });
+
     QTest::newRow("add label to empty line") << "label1 0\n"
                                                 "\n"
                                                 "label3 0" <<
@@ -201,3 +215,270 @@ void DocumentLabelIndexTest::testSignals()
         QVERIFY(removedSpy.contains(*e));
     }
 }
+
+// Checks that looking a label up by name and by line agree for every line
+static void verifyLookups(const DocumentLabelIndex& index, int numLines)
+{
+    int numDeclarations = 0;
+    for (int line = 0; line < numLines; ++line) {
+        const QString label = index.labelAtLine(line);
+        QCOMPARE(index.hasLabelAtLine(line), !label.isNull());
+        if (!label.isNull()) {
+            QCOMPARE(index.lineNumberOfLabel(label), line);
+            ++numDeclarations;
+        }
+    }
+    QCOMPARE(numDeclarations, index.labels().size());
+}
+
+void DocumentLabelIndexTest::testLineLookup()
+{
+    QTextDocument doc("a\tadd\tb\tc\tc\n"
+                      "\n"
+                      "b\t0\n"
+                      "c\t1");
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+
+    QCOMPARE(index.labelAtLine(0), QString("a"));
+    QVERIFY(!index.hasLabelAtLine(1));
+    QCOMPARE(index.labelAtLine(2), QString("b"));
+    verifyLookups(index, doc.blockCount());
+
+    // Insert lines above the labels
+    cursor.setPosition(0);
+    cursor.insertText("d\t2\n\n");
+    QCOMPARE(index.labelAtLine(0), QString("d"));
+    QCOMPARE(index.labelAtLine(2), QString("a"));
+    QCOMPARE(index.labelAtLine(5), QString("c"));
+    verifyLookups(index, doc.blockCount());
+
+    // Remove the lines of "d" and "a"
+    cursor.setPosition(0);
+    cursor.setPosition(doc.findBlockByNumber(3).position(), QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QVERIFY(!index.hasLabel("a"));
+    QCOMPARE(index.labelAtLine(1), QString("b"));
+    QCOMPARE(index.labelAtLine(2), QString("c"));
+    verifyLookups(index, doc.blockCount());
+
+    // Rename "b" in place
+    cursor.setPosition(doc.findBlockByNumber(1).position());
+    cursor.insertText("e");
+    QVERIFY(!index.hasLabel("b"));
+    QCOMPARE(index.labelAtLine(1), QString("eb"));
+    verifyLookups(index, doc.blockCount());
+}
+
+void DocumentLabelIndexTest::testReferences()
+{
+    QTextDocument doc("a\tadd\tb\tc\tc\n"
+                      "\tcp\tc\tb\n"
+                      "b\t0\n"
+                      "c\t1");
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+
+    QSignalSpy changedSpy(&index, SIGNAL(referencesChanged(QString)));
+
+    QCOMPARE(index.referencesOfLabel("a"), QList<int>());
+    QCOMPARE(index.referencesOfLabel("b"), QList<int>({0, 1}));
+    QCOMPARE(index.referencesOfLabel("c"), QList<int>({0, 1}));
+    QCOMPARE(index.numReferences("c"), 2);
+
+    // Swap an operand on the second line
+    cursor.setPosition(doc.findBlockByNumber(1).position() + 4);
+    cursor.deleteChar();
+    cursor.insertText("a");
+    QCOMPARE(index.referencesOfLabel("a"), QList<int>({1}));
+    QCOMPARE(index.referencesOfLabel("c"), QList<int>({0}));
+    QVERIFY(changedSpy.contains(QList<QVariant>({"a"})));
+    QVERIFY(changedSpy.contains(QList<QVariant>({"c"})));
+
+    // Uses move with their lines
+    cursor.setPosition(0);
+    cursor.insertText("\n\n");
+    QCOMPARE(index.referencesOfLabel("b"), QList<int>({2, 3}));
+
+    // And go away with them
+    cursor.setPosition(doc.findBlockByNumber(2).position());
+    cursor.setPosition(doc.findBlockByNumber(3).position(), QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QCOMPARE(index.referencesOfLabel("b"), QList<int>({2}));
+    QCOMPARE(index.referencesOfLabel("c"), QList<int>());
+    QCOMPARE(index.numReferences("c"), 0);
+}
+
+void DocumentLabelIndexTest::testDuplicates()
+{
+    QTextDocument doc("a\t0\n"
+                      "b\t0\n"
+                      "a\t1");
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+
+    QSignalSpy duplicateSpy(&index, SIGNAL(duplicateStateChanged(QString,bool)));
+
+    QVERIFY(index.isDuplicateLabel("a"));
+    QVERIFY(!index.isDuplicateLabel("b"));
+    QCOMPARE(index.duplicateLabels(), QList<QString>({"a"}));
+    QCOMPARE(index.definitionsOfLabel("a"), QList<int>({0, 2}));
+    QCOMPARE(index.lineNumberOfLabel("a"), 0);
+    QVERIFY(index.hasLabelAtLine("a", 2));
+
+    // Define "b" a second time
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("\nb\t2");
+    QVERIFY(index.isDuplicateLabel("b"));
+    QCOMPARE(duplicateSpy.count(), 1);
+    QCOMPARE(duplicateSpy.at(0), QList<QVariant>({"b", true}));
+
+    // Renaming the first "a" leaves the other one in place
+    cursor.setPosition(0);
+    cursor.insertText("c");
+    QVERIFY(!index.isDuplicateLabel("a"));
+    QVERIFY(index.hasLabel("a"));
+    QCOMPARE(index.lineNumberOfLabel("a"), 2);
+    QCOMPARE(duplicateSpy.count(), 2);
+    QCOMPARE(duplicateSpy.at(1), QList<QVariant>({"a", false}));
+
+    // Removing lines takes their definitions with them
+    cursor.setPosition(doc.findBlockByNumber(1).position());
+    cursor.setPosition(doc.findBlockByNumber(3).position(), QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QVERIFY(!index.hasLabel("a"));
+    QVERIFY(!index.isDuplicateLabel("b"));
+    QCOMPARE(index.definitionsOfLabel("b"), QList<int>({1}));
+    QVERIFY(index.duplicateLabels().isEmpty());
+    QCOMPARE(duplicateSpy.count(), 3);
+    QCOMPARE(duplicateSpy.at(2), QList<QVariant>({"b", false}));
+}
+
+void DocumentLabelIndexTest::testLabelTypeChange()
+{
+    QTextDocument doc("a\t0\n"
+                      "\tbe\ta\tb\tc");
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+
+    QSignalSpy typeSpy(&index, SIGNAL(labelTypeChanged(QString,int)));
+    QSignalSpy addedSpy(&index, SIGNAL(labelAdded(QString,int)));
+
+    QVERIFY(index.isVariableLabel("a"));
+
+    // Turning the data line into an instruction keeps the label but changes its type
+    cursor.setPosition(2);
+    cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+    cursor.insertText("halt");
+    QVERIFY(index.isFunctionLabel("a"));
+    QCOMPARE(typeSpy.count(), 1);
+    QCOMPARE(typeSpy.at(0), QList<QVariant>({"a", 0}));
+    QCOMPARE(addedSpy.count(), 0);
+
+    // Editing the line without changing the type says nothing
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    cursor.insertText(" ");
+    QCOMPARE(typeSpy.count(), 1);
+}
+
+void DocumentLabelIndexTest::testSymbolsReleased()
+{
+    SymbolTable* symbols = SymbolTable::instance();
+    const int initialSize = symbols->size();
+    {
+        QTextDocument doc("\tcp\t");
+        QTextCursor cursor(&doc);
+        DocumentLabelIndex index(&doc);
+
+        // Typing a use one character at a time leaves only the whole name behind
+        cursor.movePosition(QTextCursor::End);
+        foreach (QChar c, QString("releasedtest_use")) {
+            cursor.insertText(c);
+        }
+        QCOMPARE(index.referencesOfLabel("releasedtest_use"), QList<int>({0}));
+        QCOMPARE(symbols->find("releasedtest_us"), SymbolId(SymbolTable::NO_SYMBOL));
+        QCOMPARE(symbols->size(), initialSize + 1);
+
+        // And the same for a definition
+        cursor.insertText("\n");
+        foreach (QChar c, QString("releasedtest_def")) {
+            cursor.insertText(c);
+        }
+        cursor.insertText("\t0");
+        QVERIFY(index.hasLabel("releasedtest_def"));
+        QCOMPARE(symbols->find("releasedtest_de"), SymbolId(SymbolTable::NO_SYMBOL));
+        QCOMPARE(symbols->size(), initialSize + 2);
+    }
+
+    // The index gives its names back when it goes away
+    QCOMPARE(symbols->size(), initialSize);
+}
+
+void DocumentLabelIndexTest::benchmarkLargeFile_data()
+{
+    QTest::addColumn<QString>("operation");
+
+    QTest::newRow("lookup by line") << "lookup";
+    QTest::newRow("find usages") << "usages";
+    QTest::newRow("keystroke on a label") << "keystroke";
+    QTest::newRow("insert line at top") << "insert top";
+    QTest::newRow("insert line at bottom") << "insert bottom";
+}
+
+void DocumentLabelIndexTest::benchmarkLargeFile()
+{
+    QFETCH(QString, operation);
+
+    // 50k lines, every tenth of which declares a label. The rest each use one
+    // of the labels, so every label has about nine uses
+    const int numLines = 50000;
+    QString docText;
+    for (int i = 0; i < numLines; ++i) {
+        if (i % 10 == 0)
+            docText.append(QString("label%1\tadd\ta\tb\tc\n").arg(i / 10));
+        else
+            docText.append(QString("\tadd\tlabel%1\tb\tc\n").arg((i * 7) % 5000));
+    }
+
+    QTextDocument doc(docText);
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+    QCOMPARE(index.labels().size(), 5000);
+
+    if (operation == "lookup") {
+        int found = 0;
+        QBENCHMARK {
+            found = 0;
+            for (int line = 0; line < numLines; ++line) {
+                if (index.hasLabelAtLine(line))
+                    ++found;
+            }
+        }
+        QCOMPARE(found, 5000);
+    } else if (operation == "usages") {
+        QList<int> usages;
+        QBENCHMARK {
+            usages = index.referencesOfLabel("label2500");
+        }
+        QVERIFY(!usages.isEmpty());
+    } else if (operation == "keystroke") {
+        // Type into the label on the middle line and take it back out
+        const int position = doc.findBlockByNumber(numLines / 2).position() + 1;
+        QBENCHMARK {
+            cursor.setPosition(position);
+            cursor.insertText("x");
+            cursor.setPosition(position);
+            cursor.deleteChar();
+        }
+    } else {
+        // Moving the labels below the new line should not make the top any slower
+        const int position = (operation == "insert top") ? 0 : doc.lastBlock().position();
+        QBENCHMARK {
+            cursor.setPosition(position);
+            cursor.insertText("\n");
+            cursor.setPosition(position);
+            cursor.deleteChar();
+        }
+    }
+    QCOMPARE(index.lineNumberOfLabel("label4999"), numLines - 10);
+}
@@ -34,6 +34,13 @@ private slots:
     void testDocuments();
     void testSignals_data();
     void testSignals();
+    void testLineLookup();
+    void testReferences();
+    void testDuplicates();
+    void testLabelTypeChange();
+    void testSymbolsReleased();
+    void benchmarkLargeFile_data();
+    void benchmarkLargeFile();
 };
 
 #endif // DOCUMENTLABELINDEXTEST_H
@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "documentsavertest.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTextCursor>
+#include <QTextDocument>
+
+#include <documentsaver.h>
+
+namespace {
+
+const char* const BASE_TEXT = "start:\tadd\tsum\tsum\tone\n"
+                              "\tbe\tstart\tsum\tlimit\n"
+                              "\thalt\n"
+                              "one\t.data\t1\n";
+
+// What is on disk, with the platform's line endings read back as "\n"
+QByteArray savedBytes(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text))
+        return QByteArray();
+    return file.readAll();
+}
+
+}
+
+void DocumentSaverTest::testSave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/save.e";
+
+    QTextDocument doc(BASE_TEXT);
+    doc.setModified(true);
+    DocumentSaver saver(&doc);
+    QSignalSpy finished(&saver, SIGNAL(saveFinished(bool)));
+
+    saver.save(fileName);
+    QVERIFY(saver.isSaving());
+    QVERIFY(finished.wait(10000));
+
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.at(0), QList<QVariant>({true}));
+    QVERIFY(!saver.isSaving());
+    QCOMPARE(saver.fileName(), fileName);
+    QCOMPARE(savedBytes(fileName), QByteArray(BASE_TEXT));
+    QVERIFY(!doc.isModified());
+}
+
+void DocumentSaverTest::testEditDuringSave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/edited.e";
+
+    QTextDocument doc(BASE_TEXT);
+    doc.setModified(true);
+    QTextCursor cursor(&doc);
+    DocumentSaver saver(&doc);
+    QSignalSpy finished(&saver, SIGNAL(saveFinished(bool)));
+
+    // Typing after save() has taken its snapshot is not written out...
+    saver.save(fileName);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("two\t.data\t2\n");
+    QVERIFY(finished.wait(10000));
+
+    QCOMPARE(finished.at(0), QList<QVariant>({true}));
+    QCOMPARE(savedBytes(fileName), QByteArray(BASE_TEXT));
+
+    // ...and still needs saving afterwards
+    QVERIFY(doc.isModified());
+}
+
+void DocumentSaverTest::testReplaceFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/existing.e";
+    {
+        QFile file(fileName);
+        QVERIFY(file.open(QFile::WriteOnly));
+        QVERIFY(file.write("\thalt\n\thalt\n\thalt\n\thalt\n\thalt\n\thalt\n\thalt\n") > 0);
+    }
+
+    QTextDocument doc(BASE_TEXT);
+    DocumentSaver saver(&doc);
+    QSignalSpy finished(&saver, SIGNAL(saveFinished(bool)));
+
+    saver.save(fileName);
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(finished.at(0), QList<QVariant>({true}));
+
+    // The old file is replaced outright, with nothing of it left over and
+    // no temporary file left behind
+    QCOMPARE(savedBytes(fileName), QByteArray(BASE_TEXT));
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files), QStringList({"existing.e"}));
+}
+
+void DocumentSaverTest::testError()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/missing/error.e";
+
+    QTextDocument doc(BASE_TEXT);
+    doc.setModified(true);
+    DocumentSaver saver(&doc);
+    QSignalSpy finished(&saver, SIGNAL(saveFinished(bool)));
+
+    saver.save(fileName);
+    QVERIFY(finished.wait(10000));
+
+    QCOMPARE(finished.at(0), QList<QVariant>({false}));
+    QCOMPARE(saver.fileName(), fileName);
+    QVERIFY(!saver.errorString().isEmpty());
+    QVERIFY(!QFile::exists(fileName));
+    QVERIFY(doc.isModified());
+}
+
+void DocumentSaverTest::testQueuedSave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString firstFileName = dir.path() + "/first.e";
+    const QString secondFileName = dir.path() + "/second.e";
+
+    QTextDocument doc(BASE_TEXT);
+    QTextCursor cursor(&doc);
+    DocumentSaver saver(&doc);
+    QSignalSpy finished(&saver, SIGNAL(saveFinished(bool)));
+
+    // The second save waits for the first, then takes its own snapshot
+    saver.save(firstFileName);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("two\t.data\t2\n");
+    saver.save(secondFileName);
+
+    QVERIFY(saver.wait());
+    QVERIFY(!saver.isSaving());
+    QCOMPARE(finished.count(), 2);
+    QCOMPARE(saver.fileName(), secondFileName);
+    QCOMPARE(savedBytes(firstFileName), QByteArray(BASE_TEXT));
+    QCOMPARE(savedBytes(secondFileName), QByteArray(BASE_TEXT) + "two\t.data\t2\n");
+    QVERIFY(!doc.isModified());
+}
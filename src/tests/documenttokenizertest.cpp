@@ -24,12 +24,16 @@
 
 #include <QTest>
 
+#include <QElapsedTimer>
 #include <QSignalSpy>
+#include <QTextBlock>
 #include <QTextCursor>
 #include <QTextDocument>
 #include <QVector>
 
 #include <documenttokenizer.h>
+#include <linelexer.h>
+#include <tokenblockdata.h>
 #include <token.h>
 
 static const Token NEWLINE = {"\n", Token::Newline};
@@ -63,6 +67,21 @@ void compareTokenLists(const TokenList& actual, const QVector<Token>& expected)
     }
 }
 
+// Walks the tokenizer's tokens in place and compares them to the expected ones
+void compareTokens(const DocumentTokenizer& tokenizer, const QVector<Token>& expected)
+{
+    QCOMPARE(tokenizer.numTokens(), expected.size());
+
+    QVector<Token>::const_iterator e = expected.constBegin();
+    DocumentTokenizer::const_iterator i = tokenizer.constBegin();
+    for (; i != tokenizer.constEnd(); ++i, ++e) {
+        QVERIFY(e != expected.constEnd());
+        QCOMPARE(i.value().toString(), e->value);
+        QCOMPARE(i.type(), e->type);
+    }
+    QVERIFY(e == expected.constEnd());
+}
+
 DocumentTokenizerTest::DocumentTokenizerTest()
 {
 
@@ -74,6 +93,7 @@ void DocumentTokenizerTest::testEmptyDocument()
     DocumentTokenizer tokenizer(&doc);
     QVERIFY(tokenizer.numTokens() == 0);
     QVERIFY(tokenizer.tokens().size() == 0);
+    QVERIFY(tokenizer.constBegin() == tokenizer.constEnd());
 }
 
 void DocumentTokenizerTest::testNoDocument()
@@ -176,9 +196,8 @@ void DocumentTokenizerTest::documents()
 
     QTextDocument doc(docText);
     DocumentTokenizer tokenizer(&doc);
-    TokenList tokens = tokenizer.tokens();
-
-    compareTokenLists(tokens, expectedTokens);
+    compareTokenLists(tokenizer.tokens(), expectedTokens);
+    compareTokens(tokenizer, expectedTokens);
 }
 
 void DocumentTokenizerTest::testInsert_data()
@@ -305,8 +324,7 @@ void DocumentTokenizerTest::testInsert()
     QSignalSpy spy(&doc, SIGNAL(contentsChange(int, int, int)));
 
     // Compare the initial list of tokens
-    TokenList initialTokens = tokenizer.tokens();
-    compareTokenLists(initialTokens, expInitialTokens);
+    compareTokens(tokenizer, expInitialTokens);
 
     // Insert the text
 
@@ -323,8 +341,264 @@ void DocumentTokenizerTest::testInsert()
     qDebug() << spy.count();
 
     // Compare the final list of tokens
-    TokenList finalTokens = tokenizer.tokens();
-    compareTokenLists(finalTokens, expFinalTokens);
+    compareTokens(tokenizer, expFinalTokens);
+}
+
+void DocumentTokenizerTest::testBulkInsert()
+{
+    const int numPastedLines = 100000;
+
+    QTextDocument doc("top\n"
+                      "bottom 0");
+    QTextCursor cursor(&doc);
+    DocumentTokenizer tokenizer(&doc);
+
+    QSignalSpy linesAddedSpy(&tokenizer, SIGNAL(linesAdded(int,int)));
+    QSignalSpy linesRemovedSpy(&tokenizer, SIGNAL(linesRemoved(int,int)));
+
+    QString pastedText;
+    for (int i = 0; i < numPastedLines; ++i) {
+        pastedText.append(QString("label%1\tadd\ta\tb\tc\n").arg(i));
+    }
+
+    // Paste everything at the start of the second line
+    cursor.setPosition(4);
+
+    QElapsedTimer timer;
+    timer.start();
+    cursor.insertText(pastedText);
+    qDebug() << "pasting" << numPastedLines << "lines took" << timer.elapsed() << "ms";
+
+    QCOMPARE(tokenizer.numLines(), numPastedLines + 2);
+
+    // The whole paste is reported as one range of lines
+    QCOMPARE(linesAddedSpy.count(), 1);
+    QCOMPARE(linesAddedSpy.at(0).at(0).toInt(), 1);
+    QCOMPARE(linesAddedSpy.at(0).at(1).toInt(), numPastedLines);
+    QCOMPARE(linesRemovedSpy.count(), 0);
+
+    QCOMPARE(tokenizer.tokensInLine(0).valueAt(0).toString(), QString("top"));
+    QCOMPARE(tokenizer.tokensInLine(1).valueAt(0).toString(), QString("label0"));
+    QCOMPARE(tokenizer.tokensInLine(numPastedLines).valueAt(0).toString(),
+             QString("label%1").arg(numPastedLines - 1));
+    QCOMPARE(tokenizer.tokensInLine(numPastedLines + 1).valueAt(0).toString(), QString("bottom"));
+    QVERIFY(!tokenizer.tokensInLine(numPastedLines + 1).endsWithNewline());
+}
+
+void DocumentTokenizerTest::testBulkRemove()
+{
+    QTextDocument doc("one\n"
+                      "two\n"
+                      "three\n"
+                      "four");
+    QTextCursor cursor(&doc);
+    DocumentTokenizer tokenizer(&doc);
+
+    QSignalSpy linesRemovedSpy(&tokenizer, SIGNAL(linesRemoved(int,int)));
+
+    // Select from the middle of "one" to the middle of "three" and replace it
+    cursor.setPosition(2);
+    cursor.setPosition(10, QTextCursor::KeepAnchor);
+    cursor.insertText(" x ");
+
+    compareTokens(tokenizer, QVector<Token>({
+                                                {"on", Token::Label},
+                                                {"x", Token::Label},
+                                                {"ree", Token::Label},
+                                                NEWLINE,
+                                                {"four", Token::Label}
+                                            }));
+
+    QCOMPARE(linesRemovedSpy.count(), 1);
+    QCOMPARE(linesRemovedSpy.at(0).at(0).toInt(), 1);
+    QCOMPARE(linesRemovedSpy.at(0).at(1).toInt(), 2);
+}
+
+void DocumentTokenizerTest::testTokensInLines()
+{
+    QTextDocument doc("one two\n"
+                      "\n"
+                      "three\n"
+                      "four // five");
+    DocumentTokenizer tokenizer(&doc);
+
+    QCOMPARE(tokenizer.numTokens(), 8);
+
+    // The range starts at its first line and stops at the end of its last line
+    QStringList values;
+    QList<int> lineNumbers;
+    DocumentTokenizer::TokenRange range = tokenizer.tokensInLines(1, 2);
+    for (DocumentTokenizer::const_iterator i = range.begin(); i != range.end(); ++i) {
+        values.append(i.value().toString());
+        lineNumbers.append(i.lineNumber());
+    }
+    QCOMPARE(values, QStringList({"\n", "three", "\n"}));
+    QCOMPARE(lineNumbers, QList<int>({1, 2, 2}));
+
+    // Ranges are clipped to the document
+    QVERIFY(tokenizer.tokensInLines(3, 10).begin() != tokenizer.tokensInLines(3, 10).end());
+    QVERIFY(tokenizer.tokensInLines(10, 1).begin() == tokenizer.tokensInLines(10, 1).end());
+
+    // The running count follows edits
+    QTextCursor cursor(&doc);
+    cursor.setPosition(4);
+    cursor.setPosition(10, QTextCursor::KeepAnchor);
+    cursor.insertText("2\n3 x");
+    QCOMPARE(tokenizer.numTokens(), tokenizer.tokens().size());
+    QCOMPARE(tokenizer.numTokens(), 8);
+
+    cursor.select(QTextCursor::Document);
+    cursor.removeSelectedText();
+    QCOMPARE(tokenizer.numTokens(), 0);
+}
+
+void DocumentTokenizerTest::testBlockCache()
+{
+    QTextDocument doc("one two\n"
+                      "three");
+    QTextCursor cursor(&doc);
+    DocumentTokenizer tokenizer(&doc);
+
+    // Every block keeps the tokens it was lexed into
+    for (QTextBlock block = doc.begin(); block.isValid(); block = block.next()) {
+        const TokenBlockData* data = TokenBlockData::cachedData(block, block.text());
+        QVERIFY(data);
+        QCOMPARE(data->tokens().text(), block.text());
+    }
+
+    // An edit refreshes the cache of the edited block
+    cursor.setPosition(3);
+    cursor.insertText("x");
+    const QTextBlock first = doc.firstBlock();
+    const TokenBlockData* data = TokenBlockData::cachedData(first, first.text());
+    QVERIFY(data);
+    QCOMPARE(data->revision(), first.revision());
+    QCOMPARE(data->tokens().valueAt(0).toString(), QString("onex"));
+
+    // A cache made from other text is never handed out
+    TokenBlockData::store(first, LineLexer::tokenize("stale"));
+    QVERIFY(!TokenBlockData::cachedData(first, first.text()));
+    QCOMPARE(TokenBlockData::tokensOfBlock(first).valueAt(0).toString(), QString("onex"));
+}
+
+void DocumentTokenizerTest::testChangeJournal()
+{
+    QTextDocument doc("one\n"
+                      "two");
+    QTextCursor cursor(&doc);
+    DocumentTokenizer tokenizer(&doc);
+
+    const int start = tokenizer.generation();
+    bool ok = false;
+    QVERIFY(tokenizer.changesSince(start, &ok).isEmpty());
+    QVERIFY(ok);
+
+    // Type on the first line, then split the second one
+    cursor.setPosition(1);
+    cursor.insertText("x");
+    cursor.setPosition(6);
+    cursor.insertText("\n");
+
+    QVector<LineRangeChange> changes = tokenizer.changesSince(start, &ok);
+    QVERIFY(ok);
+    QCOMPARE(changes.size(), 2);
+    QCOMPARE(changes.at(0).generation, start + 1);
+    QCOMPARE(changes.at(0).firstLine, 0);
+    QCOMPARE(changes.at(0).oldCount, 1);
+    QCOMPARE(changes.at(0).newCount, 1);
+    QCOMPARE(changes.at(1).generation, start + 2);
+    QCOMPARE(changes.at(1).firstLine, 1);
+    QCOMPARE(changes.at(1).oldCount, 1);
+    QCOMPARE(changes.at(1).newCount, 2);
+    QCOMPARE(tokenizer.generation(), start + 2);
+
+    // Catching up from the middle only returns the later change
+    changes = tokenizer.changesSince(start + 1);
+    QCOMPARE(changes.size(), 1);
+    QCOMPARE(changes.at(0).generation, start + 2);
+
+    // A consumer that falls too far behind is told so
+    for (int i = 0; i < 2 * DocumentTokenizer::JOURNAL_CAPACITY; ++i) {
+        cursor.insertText("y");
+    }
+    QVERIFY(tokenizer.changesSince(start, &ok).isEmpty());
+    QVERIFY(!ok);
+    changes = tokenizer.changesSince(tokenizer.generation() - DocumentTokenizer::JOURNAL_CAPACITY, &ok);
+    QVERIFY(ok);
+    QCOMPARE(changes.size(), DocumentTokenizer::JOURNAL_CAPACITY);
+}
+
+void DocumentTokenizerTest::testBackgroundParse()
+{
+    const int numLines = 3 * DocumentTokenizer::BACKGROUND_PARSE_MIN_LINES;
+
+    QTextDocument doc;
+    QTextCursor cursor(&doc);
+    DocumentTokenizer tokenizer(&doc);
+    tokenizer.setBackgroundParsingEnabled(true);
+
+    QSignalSpy finishedSpy(&tokenizer, SIGNAL(parsingFinished()));
+    QSignalSpy parsedSpy(&tokenizer, SIGNAL(linesParsed(int,int)));
+
+    QString docText;
+    for (int i = 0; i < numLines; ++i) {
+        docText.append(QString("label%1\tadd\ta\tb\tc\n").arg(i));
+    }
+    doc.setPlainText(docText);
+
+    // The lines exist right away, even before their tokens do
+    QVERIFY(tokenizer.isParsing());
+    QCOMPARE(tokenizer.numLines(), numLines + 1);
+
+    // Edit the document while the parse is running
+    cursor.setPosition(0);
+    cursor.insertText("first\t0\n");
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("last");
+
+    QVERIFY(finishedSpy.wait(10000));
+    QVERIFY(!tokenizer.isParsing());
+    QVERIFY(parsedSpy.count() > 0);
+
+    // The result must match a tokenizer that parsed the final text directly
+    QTextDocument finalDoc(doc.toPlainText());
+    DocumentTokenizer expected(&finalDoc);
+    QCOMPARE(tokenizer.numLines(), expected.numLines());
+    compareTokens(tokenizer, QVector<Token>::fromList(expected.tokens()));
+}
+
+void DocumentTokenizerTest::benchmarkKeystroke_data()
+{
+    QTest::addColumn<int>("numLines");
+
+    QTest::newRow("1k lines") << 1000;
+    QTest::newRow("10k lines") << 10000;
+    QTest::newRow("100k lines") << 100000;
+}
+
+void DocumentTokenizerTest::benchmarkKeystroke()
+{
+    // The time per keystroke should not grow with the size of the document
+    QFETCH(int, numLines);
+
+    QString docText;
+    for (int i = 0; i < numLines; ++i) {
+        docText.append(QString("label%1\tadd\ta\tb\tc\n").arg(i));
+    }
+
+    QTextDocument doc(docText);
+    QTextCursor cursor(&doc);
+    DocumentTokenizer tokenizer(&doc);
+
+    // Type in the middle of the document
+    cursor.setPosition(doc.findBlockByNumber(numLines / 2).position() + 5);
+
+    QBENCHMARK {
+        cursor.insertText("x");
+        cursor.deletePreviousChar();
+    }
+
+    QCOMPARE(tokenizer.numLines(), numLines + 1);
 }
 
 void DocumentTokenizerTest::testSignalSpy()
@@ -40,6 +40,14 @@ private slots:
     void documents();
     void testInsert_data();
     void testInsert();
+    void testBulkInsert();
+    void testBulkRemove();
+    void testTokensInLines();
+    void testBlockCache();
+    void testChangeJournal();
+    void testBackgroundParse();
+    void benchmarkKeystroke_data();
+    void benchmarkKeystroke();
     void testSignalSpy();
     void testCursorMove();
 };
@@ -0,0 +1,194 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "editjournaltest.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTextCursor>
+#include <QTextDocument>
+
+#include <editjournal.h>
+
+namespace {
+
+const char* const BASE_TEXT = "start:\tadd\tsum\tsum\tone\n"
+                              "\tbe\tstart\tsum\tlimit\n"
+                              "\thalt\n"
+                              "one\t.data\t1\n";
+
+void writeFile(const QString& fileName, const QString& text)
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    file.write(text.toUtf8());
+}
+
+QString replayed(const QString& journalFile, const QString& baseFile)
+{
+    QString text = BASE_TEXT;
+    if (!EditJournal::replay(journalFile, baseFile, &text))
+        return QString();
+    return text;
+}
+
+}
+
+void EditJournalTest::testReplay()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString baseFile = dir.path() + "/sum.e";
+    const QString journalFile = dir.path() + "/sum.journal";
+    writeFile(baseFile, BASE_TEXT);
+
+    QTextDocument doc(BASE_TEXT);
+    EditJournal journal(&doc);
+    QVERIFY(journal.start(journalFile, baseFile));
+    QVERIFY(journal.isActive());
+
+    // Rehighlighting marks text as changed without changing it
+    const qint64 emptySize = journal.size();
+    doc.markContentsDirty(0, doc.characterCount() - 1);
+    QCOMPARE(journal.size(), emptySize);
+
+    // Typing, deleting and replacing, across lines and at the very end
+    QTextCursor cursor(&doc);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("limit\t.data\t10\nsum\t.data\t0");
+    cursor.setPosition(0);
+    cursor.insertText("// Adds up to limit\n");
+    cursor.movePosition(QTextCursor::NextBlock);
+    cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    cursor.insertText("loop:\tadd\tsum\tsum\tone");
+    cursor.movePosition(QTextCursor::NextBlock);
+    cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    doc.undo();
+    doc.redo();
+
+    journal.flush();
+    QCOMPARE(replayed(journalFile, baseFile), doc.toPlainText());
+
+    // Starting again against the same file throws the old edits away
+    QVERIFY(journal.start(journalFile, baseFile));
+    QCOMPARE(replayed(journalFile, baseFile), doc.toPlainText());
+    doc.setModified(false);
+    QVERIFY(journal.start(journalFile, baseFile));
+    QCOMPARE(replayed(journalFile, baseFile), QString(BASE_TEXT));
+
+    // A discarded journal has nothing to replay
+    journal.discard();
+    QVERIFY(!journal.isActive());
+    QVERIFY(!QFile::exists(journalFile));
+    QVERIFY(replayed(journalFile, baseFile).isNull());
+}
+
+void EditJournalTest::testStaleJournal()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString baseFile = dir.path() + "/sum.e";
+    const QString journalFile = dir.path() + "/sum.journal";
+    writeFile(baseFile, BASE_TEXT);
+
+    QTextDocument doc(BASE_TEXT);
+    EditJournal journal(&doc);
+    QVERIFY(journal.start(journalFile, baseFile));
+    QTextCursor cursor(&doc);
+    cursor.insertText("// Stale\n");
+    journal.stop();
+
+    // The file was changed by something else after the journal was started
+    writeFile(baseFile, QString(BASE_TEXT) + "\thalt\n");
+    QString text = BASE_TEXT;
+    QVERIFY(!EditJournal::replay(journalFile, baseFile, &text));
+    QCOMPARE(text, QString(BASE_TEXT));
+}
+
+void EditJournalTest::testTruncatedJournal()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString baseFile = dir.path() + "/sum.e";
+    const QString journalFile = dir.path() + "/sum.journal";
+    writeFile(baseFile, BASE_TEXT);
+
+    QTextDocument doc(BASE_TEXT);
+    EditJournal journal(&doc);
+    QVERIFY(journal.start(journalFile, baseFile));
+
+    QTextCursor cursor(&doc);
+    cursor.insertText("// Kept\n");
+    const QString keptText = doc.toPlainText();
+    const qint64 keptSize = journal.size();
+
+    cursor.insertText("// Cut short by a crash\n");
+    journal.stop();
+
+    // Only part of the last record made it to disk
+    QVERIFY(QFile::resize(journalFile, keptSize + 7));
+    QCOMPARE(replayed(journalFile, baseFile), keptText);
+}
+
+void EditJournalTest::testCompaction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString baseFile = dir.path() + "/sum.e";
+    const QString journalFile = dir.path() + "/sum.journal";
+    writeFile(baseFile, BASE_TEXT);
+
+    QTextDocument doc(BASE_TEXT);
+    EditJournal journal(&doc);
+    QSignalSpy compactedSpy(&journal, SIGNAL(compacted()));
+    QVERIFY(journal.start(journalFile, baseFile));
+
+    // Lots of typing and deleting that adds up to very little
+    QTextCursor cursor(&doc);
+    cursor.movePosition(QTextCursor::End);
+    for (int i = 0; i < 2000; ++i) {
+        cursor.insertText("x");
+        cursor.deletePreviousChar();
+    }
+    cursor.insertText("sum\t.data\t0\n");
+    const qint64 sizeBefore = journal.size();
+
+    journal.compact();
+    QVERIFY(journal.isCompacting());
+
+    // Edits made while the compactor runs follow its snapshot
+    cursor.insertText("limit\t.data\t10\n");
+    QVERIFY(compactedSpy.wait(10000));
+    QVERIFY(!journal.isCompacting());
+    QVERIFY(journal.size() < sizeBefore);
+
+    cursor.setPosition(0);
+    cursor.insertText("// Adds up to limit\n");
+
+    journal.flush();
+    QCOMPARE(QFile(journalFile).size(), journal.size());
+    QCOMPARE(replayed(journalFile, baseFile), doc.toPlainText());
+}
@@ -0,0 +1,284 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "fileloadertest.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <fileloader.h>
+
+namespace {
+
+void writeFile(const QString& fileName, const QByteArray& bytes)
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    QCOMPARE(file.write(bytes), qint64(bytes.size()));
+}
+
+// Everything handed out through chunkLoaded(), in order
+QString loadedText(const QSignalSpy& chunks)
+{
+    QString text;
+    for (int i = 0; i < chunks.count(); ++i) {
+        text.append(chunks.at(i).at(0).toString());
+    }
+    return text;
+}
+
+// Filler that puts the byte after it at offset
+QByteArray padding(int offset)
+{
+    return QByteArray(offset, 'a');
+}
+
+// Starts a new high-water mark for peakResidentKb(), where the platform allows
+void resetPeakResident()
+{
+#ifdef Q_OS_LINUX
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QFile::WriteOnly))
+        clearRefs.write("5");
+#endif
+}
+
+// The most memory the process has had resident, in kB, or -1 if unknown
+qint64 peakResidentKb()
+{
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (status.open(QFile::ReadOnly)) {
+        foreach (const QByteArray& line, status.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:"))
+                return line.mid(6).simplified().split(' ').first().toLongLong();
+        }
+    }
+#endif
+    return -1;
+}
+
+}
+
+void FileLoaderTest::testLineEndingsAcrossChunks_data()
+{
+    QTest::addColumn<bool>("mapped");
+
+    QTest::newRow("mapped") << true;
+    QTest::newRow("read") << false;
+}
+
+void FileLoaderTest::testLineEndingsAcrossChunks()
+{
+    QFETCH(bool, mapped);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/crlf.e";
+
+    // A "\r\n" straddling the end of the first chunk, and one straddling
+    // the end of the second
+    QByteArray bytes = padding(FileLoader::FIRST_CHUNK_SIZE - 1) + "\r\n";
+    bytes += padding(FileLoader::FIRST_CHUNK_SIZE + FileLoader::CHUNK_SIZE - 1 - bytes.size()) + "\r\n";
+    bytes += "\thalt\r\n";
+    writeFile(fileName, bytes);
+
+    FileLoader loader(fileName);
+    loader.setMemoryMapped(mapped);
+    QSignalSpy chunks(&loader, SIGNAL(chunkLoaded(QString)));
+    QSignalSpy finished(&loader, SIGNAL(finished()));
+    QVERIFY(loader.open());
+    QCOMPARE(loader.isMemoryMapped(), mapped);
+
+    loader.start();
+    QVERIFY(finished.wait(10000));
+    QVERIFY(chunks.count() >= 3);
+
+    QString expected = QString::fromLatin1(bytes);
+    expected.replace("\r\n", "\n");
+    QCOMPARE(loadedText(chunks), expected);
+    QCOMPARE(loader.bytesLoaded(), qint64(bytes.size()));
+}
+
+void FileLoaderTest::testCharacterAcrossChunks()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/utf8.e";
+
+    // The two bytes of an "é" either side of the end of the first chunk. The
+    // byte order mark keeps the test from depending on the locale's codec
+    const QByteArray bom("\xef\xbb\xbf");
+    const QByteArray e("\xc3\xa9");
+    QByteArray bytes = bom + padding(FileLoader::FIRST_CHUNK_SIZE - 1 - bom.size()) + e + "\n";
+    writeFile(fileName, bytes);
+
+    FileLoader loader(fileName);
+    QSignalSpy chunks(&loader, SIGNAL(chunkLoaded(QString)));
+    QSignalSpy finished(&loader, SIGNAL(finished()));
+    QVERIFY(loader.open());
+
+    loader.start();
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(chunks.count(), 2);
+
+    const QString expected = QString::fromLatin1(padding(FileLoader::FIRST_CHUNK_SIZE - 1 - bom.size()))
+                             + QChar(0xe9) + "\n";
+    QCOMPARE(loadedText(chunks), expected);
+}
+
+void FileLoaderTest::testByteOrderMark()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/utf16.e";
+
+    // Little-endian UTF-16 behind its byte order mark
+    const QString text = QString("start:\tcp\tx\t") + QChar(0x3bb) + "\n\thalt\n";
+    QByteArray bytes("\xff\xfe");
+    foreach (const QChar& c, text) {
+        bytes.append(char(c.unicode() & 0xff));
+        bytes.append(char(c.unicode() >> 8));
+    }
+    writeFile(fileName, bytes);
+
+    FileLoader loader(fileName);
+    QSignalSpy chunks(&loader, SIGNAL(chunkLoaded(QString)));
+    QSignalSpy finished(&loader, SIGNAL(finished()));
+    QVERIFY(loader.open());
+
+    // A file this small is read before start() returns, without its mark
+    loader.start();
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(loadedText(chunks), text);
+}
+
+void FileLoaderTest::testCancel()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/big.e";
+    writeFile(fileName, padding(FileLoader::FIRST_CHUNK_SIZE + 3 * FileLoader::CHUNK_SIZE));
+
+    FileLoader loader(fileName);
+    QSignalSpy chunks(&loader, SIGNAL(chunkLoaded(QString)));
+    QSignalSpy finished(&loader, SIGNAL(finished()));
+    QSignalSpy cancelled(&loader, SIGNAL(cancelled()));
+    QVERIFY(loader.open());
+
+    // Only the first chunk is in when start() returns
+    loader.start();
+    QVERIFY(loader.isLoading());
+    QCOMPARE(chunks.count(), 1);
+
+    loader.cancel();
+    QVERIFY(!loader.isLoading());
+    QCOMPARE(cancelled.count(), 1);
+
+    // Nothing more arrives once the chunk already scheduled would have run
+    QTest::qWait(100);
+    QCOMPARE(chunks.count(), 1);
+    QCOMPARE(finished.count(), 0);
+
+    // Cancelling again does nothing
+    loader.cancel();
+    QCOMPARE(cancelled.count(), 1);
+}
+
+void FileLoaderTest::testShortRead_data()
+{
+    QTest::addColumn<bool>("mapped");
+
+    QTest::newRow("mapped") << true;
+    QTest::newRow("read") << false;
+}
+
+void FileLoaderTest::testShortRead()
+{
+    QFETCH(bool, mapped);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/shrinking.e";
+    writeFile(fileName, padding(FileLoader::FIRST_CHUNK_SIZE + 3 * FileLoader::CHUNK_SIZE));
+
+    FileLoader loader(fileName);
+    loader.setMemoryMapped(mapped);
+    QSignalSpy chunks(&loader, SIGNAL(chunkLoaded(QString)));
+    QSignalSpy finished(&loader, SIGNAL(finished()));
+    QSignalSpy failed(&loader, SIGNAL(failed()));
+    QVERIFY(loader.open());
+    QCOMPARE(loader.isMemoryMapped(), mapped);
+
+    // The file is cut short after it was opened, part way into the second chunk
+    QVERIFY(QFile::resize(fileName, FileLoader::FIRST_CHUNK_SIZE + 10));
+
+    loader.start();
+    QVERIFY(failed.wait(10000));
+    QVERIFY(!loader.isLoading());
+    QCOMPARE(finished.count(), 0);
+    QCOMPARE(chunks.count(), 1);
+    QVERIFY(!loader.errorString().isEmpty());
+}
+
+void FileLoaderTest::benchmarkLargeFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/large.e";
+
+    // 50 MB of typical lines
+    const QByteArray line("loop\tadd\tcount\tone\tcount\n");
+    const int size = 50 * 1024 * 1024;
+    QByteArray bytes;
+    bytes.reserve(size + line.size());
+    while (bytes.size() < size) {
+        bytes.append(line);
+    }
+    writeFile(fileName, bytes);
+    bytes.clear();
+    bytes.squeeze();
+
+    // The editor paints as soon as the first chunk is in
+    QBENCHMARK {
+        FileLoader loader(fileName);
+        QSignalSpy chunks(&loader, SIGNAL(chunkLoaded(QString)));
+        QVERIFY(loader.open());
+        loader.start();
+        QCOMPARE(chunks.count(), 1);
+        loader.cancel();
+    }
+
+    // Then the whole file once, keeping the text as the document would
+    resetPeakResident();
+    FileLoader loader(fileName);
+    QSignalSpy chunks(&loader, SIGNAL(chunkLoaded(QString)));
+    QSignalSpy finished(&loader, SIGNAL(finished()));
+    QVERIFY(loader.open());
+    loader.start();
+    QVERIFY(finished.wait(60000));
+    QCOMPARE(loader.bytesLoaded(), loader.size());
+    qDebug() << "loading" << loader.size() / (1024 * 1024) << "MB peaked at" << peakResidentKb() << "kB resident";
+}
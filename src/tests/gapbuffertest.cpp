@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "gapbuffertest.h"
+
+#include <QTest>
+#include <QVector>
+
+#include <gapbuffer.h>
+
+static void compareBuffers(const GapBuffer<int>& actual, const QVector<int>& expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    for (int i = 0; i < expected.size(); ++i) {
+        QCOMPARE(actual.at(i), expected.at(i));
+    }
+}
+
+void GapBufferTest::testInsertRemove()
+{
+    GapBuffer<int> buffer;
+    QVERIFY(buffer.isEmpty());
+
+    for (int i = 0; i < 5; ++i) {
+        buffer.append(i);
+    }
+    compareBuffers(buffer, QVector<int>({0, 1, 2, 3, 4}));
+
+    // Insert at the front, then in the middle, so the gap has to move
+    buffer.insert(0, 2, 9);
+    compareBuffers(buffer, QVector<int>({9, 9, 0, 1, 2, 3, 4}));
+    buffer.insert(4, 1, 7);
+    compareBuffers(buffer, QVector<int>({9, 9, 0, 1, 7, 2, 3, 4}));
+
+    buffer.remove(1, 3);
+    compareBuffers(buffer, QVector<int>({9, 1, 7, 2, 3, 4}));
+    buffer.remove(4, 2);
+    compareBuffers(buffer, QVector<int>({9, 1, 7, 2}));
+
+    buffer[2] = 8;
+    compareBuffers(buffer, QVector<int>({9, 1, 8, 2}));
+
+    buffer.clear();
+    QVERIFY(buffer.isEmpty());
+}
+
+void GapBufferTest::testRandomEdits()
+{
+    // Mirror a series of pseudo-random edits in a QVector and compare
+    GapBuffer<int> buffer;
+    QVector<int> expected;
+    uint seed = 12345;
+    for (int step = 0; step < 2000; ++step) {
+        seed = seed * 1103515245 + 12345;
+        const int size = expected.size();
+        const int i = (seed >> 8) % (size + 1);
+        if ((seed >> 4) % 3 != 0 || size == 0) {
+            const int count = (seed >> 16) % 4;
+            buffer.insert(i, count, step);
+            expected.insert(i, count, step);
+        } else {
+            const int count = qMin<int>((seed >> 16) % 4, size - i);
+            buffer.remove(i, count);
+            expected.remove(i, count);
+        }
+    }
+    compareBuffers(buffer, expected);
+}
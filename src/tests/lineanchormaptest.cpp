@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "lineanchormaptest.h"
+
+#include <QMap>
+#include <QTest>
+
+#include <lineanchormap.h>
+
+typedef LineAnchorMap<int> IntAnchors;
+
+static void compareAnchors(const IntAnchors& anchors, const QMap<int, int>& expected)
+{
+    QCOMPARE(anchors.size(), expected.size());
+    const IntAnchors::Anchor* anchor = anchors.first();
+    QMap<int, int>::const_iterator e = expected.constBegin();
+    for (; e != expected.constEnd(); ++e, anchor = anchors.next(anchor)) {
+        QVERIFY(anchor);
+        QCOMPARE(anchors.lineOf(anchor), e.key());
+        QCOMPARE(anchor->value(), e.value());
+        QVERIFY(anchors.find(e.key()) == anchor);
+    }
+    QVERIFY(!anchor);
+}
+
+void LineAnchorMapTest::testShift()
+{
+    IntAnchors anchors;
+    IntAnchors::Anchor* a = anchors.insert(10, 1);
+    IntAnchors::Anchor* b = anchors.insert(20, 2);
+    IntAnchors::Anchor* c = anchors.insert(30, 3);
+
+    // Insert 5 lines before b
+    anchors.shift(15, 5);
+    QCOMPARE(anchors.lineOf(a), 10);
+    QCOMPARE(anchors.lineOf(b), 25);
+    QCOMPARE(anchors.lineOf(c), 35);
+
+    // Remove lines 11 to 24, then everything after them moves up
+    anchors.shift(25, -14);
+    QCOMPARE(anchors.lineOf(b), 11);
+    QCOMPARE(anchors.lineOf(c), 21);
+    QVERIFY(!anchors.find(25));
+    QCOMPARE(anchors.lowerBound(12), c);
+
+    anchors.remove(b);
+    QCOMPARE(anchors.size(), 2);
+    QCOMPARE(anchors.next(a), c);
+    QCOMPARE(anchors.lineOf(c), 21);
+
+    anchors.clear();
+    QVERIFY(anchors.isEmpty());
+    QVERIFY(!anchors.first());
+}
+
+void LineAnchorMapTest::testRandomEdits()
+{
+    // Mirror a series of pseudo-random edits in a QMap and compare
+    IntAnchors anchors;
+    QMap<int, int> expected;
+    QMap<int, IntAnchors::Anchor*> anchorsByValue;
+    uint seed = 12345;
+    for (int step = 0; step < 5000; ++step) {
+        seed = seed * 1103515245 + 12345;
+        const int line = (seed >> 8) % 500;
+        const int count = (seed >> 20) % 10 + 1;
+        QMap<int, int> shifted;
+
+        switch ((seed >> 4) % 4) {
+        case 0:
+            if (!expected.contains(line)) {
+                anchorsByValue[step] = anchors.insert(line, step);
+                expected[line] = step;
+            }
+            break;
+        case 1:
+            if (!expected.isEmpty()) {
+                QMap<int, int>::iterator i = expected.lowerBound(line);
+                if (i == expected.end())
+                    i = expected.begin();
+                anchors.remove(anchorsByValue.take(i.value()));
+                expected.erase(i);
+            }
+            break;
+        case 2:
+            // Insert count lines at line
+            anchors.shift(line, count);
+            for (QMap<int, int>::const_iterator i = expected.constBegin(); i != expected.constEnd(); ++i) {
+                shifted.insert(i.key() >= line ? i.key() + count : i.key(), i.value());
+            }
+            expected = shifted;
+            break;
+        case 3:
+            // Remove count lines starting at line, along with their anchors
+            for (QMap<int, int>::const_iterator i = expected.constBegin(); i != expected.constEnd(); ++i) {
+                if (i.key() >= line && i.key() < line + count)
+                    anchors.remove(anchorsByValue.take(i.value()));
+                else
+                    shifted.insert(i.key() >= line + count ? i.key() - count : i.key(), i.value());
+            }
+            anchors.shift(line + count, -count);
+            expected = shifted;
+            break;
+        }
+
+        if (step % 100 == 0)
+            compareAnchors(anchors, expected);
+    }
+    compareAnchors(anchors, expected);
+}
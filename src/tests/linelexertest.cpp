@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "linelexertest.h"
+
+#include <QTest>
+
+#include <linelexer.h>
+#include <token.h>
+
+Q_DECLARE_METATYPE(Token::TokenType)
+
+void LineLexerTest::testClassify_data()
+{
+    QTest::addColumn<QString>("word");
+    QTest::addColumn<Token::TokenType>("expectedType");
+
+    QTest::newRow("label") << "label" << Token::Label;
+    QTest::newRow("label with digits") << "label69" << Token::Label;
+    QTest::newRow("label with underscore") << "func_ra" << Token::Label;
+    QTest::newRow("instruction") << "add" << Token::Instruction;
+    QTest::newRow("uppercase instruction") << "CPFA" << Token::Instruction;
+    QTest::newRow("instruction prefix") << "bn" << Token::Label;
+    QTest::newRow("instruction suffix") << "calls" << Token::Label;
+    QTest::newRow("include") << "#include" << Token::Include;
+    QTest::newRow("include typo") << "#includes" << Token::Unrecognized;
+    QTest::newRow("include file") << "lib/io.e" << Token::IncludeFile;
+    QTest::newRow("relative include file") << "../io.e" << Token::IncludeFile;
+    QTest::newRow("numeric include file") << "1.e" << Token::IncludeFile;
+    QTest::newRow("bare extension") << ".e" << Token::Unrecognized;
+    QTest::newRow("decimal") << "1234" << Token::IntLiteral;
+    QTest::newRow("negative") << "-42" << Token::IntLiteral;
+    QTest::newRow("minus") << "-" << Token::Unrecognized;
+    QTest::newRow("hex") << "0x12aF" << Token::IntLiteral;
+    QTest::newRow("hex prefix") << "0x" << Token::Unrecognized;
+    QTest::newRow("uppercase hex prefix") << "0X12" << Token::Unrecognized;
+    QTest::newRow("negative hex") << "-0x12" << Token::Unrecognized;
+    QTest::newRow("char") << "'a'" << Token::CharLiteral;
+    QTest::newRow("quote char") << "'''" << Token::CharLiteral;
+    QTest::newRow("long char") << "'ab'" << Token::Unrecognized;
+    QTest::newRow("comment") << "//hi" << Token::Comment;
+    QTest::newRow("question") << "?" << Token::Unrecognized;
+}
+
+void LineLexerTest::testClassify()
+{
+    QFETCH(QString, word);
+    QFETCH(Token::TokenType, expectedType);
+
+    QCOMPARE(Token::TYPE_NAMES[LineLexer::classifyWithRegex(word)], Token::TYPE_NAMES[expectedType]);
+
+    // Comments are split off by tokenize(), never by classify()
+    if (expectedType != Token::Comment)
+        QCOMPARE(Token::TYPE_NAMES[LineLexer::classify(word)], Token::TYPE_NAMES[expectedType]);
+}
+
+void LineLexerTest::testParity_data()
+{
+    QTest::addColumn<QString>("line");
+
+    QTest::newRow("empty") << "";
+    QTest::newRow("whitespace") << " \t  ";
+    QTest::newRow("one label") << "label";
+    QTest::newRow("label with spaces") << "label  ";
+    QTest::newRow("comment") << "// this is a comment";
+    QTest::newRow("comment with trailing space") << "// spooky comment  ";
+    QTest::newRow("comment after code") << "whole // lotta labels";
+    QTest::newRow("comment glued to word") << "label//comment";
+    QTest::newRow("triple slash") << "a///b";
+    QTest::newRow("single slash") << "a/b c";
+    QTest::newRow("function line") << "function_thing\tadd\ta\tb\tc";
+    QTest::newRow("indented instruction") << "\t\tret\tfunc_ra";
+    QTest::newRow("data line") << "a\t0x12\t?";
+    QTest::newRow("include") << "#include ../lib/io.e";
+    QTest::newRow("char literals") << "c\t'a'\t'''\t'ab'";
+    QTest::newRow("numbers") << "n -5 - 0 007 0x 0xFF 0X1 12ab";
+    QTest::newRow("carriage return") << "hello\r";
+    QTest::newRow("unicode") << "café été x y";
+    QTest::newRow("garbage") << "adsfj;vn;sakjdl;v ans;dkjfvv  ";
+}
+
+void LineLexerTest::testParity()
+{
+    QFETCH(QString, line);
+
+    TokenList expected = LineLexer::tokenizeWithRegex(line);
+    TokenList actual = LineLexer::tokenize(line).toList();
+
+    QCOMPARE(actual.size(), expected.size());
+    for (int i = 0; i < actual.size(); ++i) {
+        QCOMPARE(actual[i].value, expected[i].value);
+        QCOMPARE(Token::TYPE_NAMES[actual[i].type], Token::TYPE_NAMES[expected[i].type]);
+    }
+}
+
+void LineLexerTest::testSpans()
+{
+    const QString line("loop\tbne\tloop // again");
+    TokenLine tokens = LineLexer::tokenize(line);
+
+    QCOMPARE(tokens.size(), 5);
+    QCOMPARE(tokens.text(), line);
+
+    QCOMPARE(tokens.at(0).column, 0);
+    QCOMPARE(tokens.at(0).length, 4);
+    QCOMPARE(tokens.at(1).column, 5);
+    QCOMPARE(tokens.at(1).length, 3);
+    QCOMPARE(tokens.at(2).column, 9);
+    QCOMPARE(tokens.at(3).column, 14);
+    QCOMPARE(tokens.valueAt(3).toString(), QString("// again"));
+
+    // The newline token sits just past the end of the text
+    QCOMPARE(tokens.at(4).column, line.length());
+    QCOMPARE(tokens.valueAt(4).toString(), QString("\n"));
+
+    tokens.removeTrailingNewline();
+    QCOMPARE(tokens.size(), 4);
+    QVERIFY(!tokens.endsWithNewline());
+}
+
+typedef QVector<int> EditList;
+
+void LineLexerTest::testDiff_data()
+{
+    // Each edit is written as oldIndex, oldCount, newIndex, newCount
+    QTest::addColumn<QString>("from");
+    QTest::addColumn<QString>("to");
+    QTest::addColumn<EditList>("expectedEdits");
+
+    QTest::newRow("same") << "a add b c" << "a add b c" << EditList();
+    QTest::newRow("append") << "a add" << "a add b" << EditList({2, 0, 2, 1});
+    QTest::newRow("prepend") << "add b" << "x add b" << EditList({0, 0, 0, 1});
+    QTest::newRow("replace middle") << "a add b c" << "a sub b c" << EditList({1, 1, 1, 1});
+    QTest::newRow("duplicate removed") << "a a" << "a" << EditList({1, 1, 1, 0});
+    QTest::newRow("two spots") << "a b c d e" << "a x c d y" << EditList({1, 1, 1, 1, 4, 1, 4, 1});
+    QTest::newRow("moved") << "a b c" << "b c a" << EditList({0, 1, 0, 0, 3, 0, 2, 1});
+    QTest::newRow("type only") << "'a'" << "a" << EditList({0, 1, 0, 1});
+}
+
+void LineLexerTest::testDiff()
+{
+    QFETCH(QString, from);
+    QFETCH(QString, to);
+    QFETCH(EditList, expectedEdits);
+
+    const TokenLineDiff diff = TokenLine::diff(LineLexer::tokenize(from), LineLexer::tokenize(to));
+
+    EditList edits;
+    foreach (const TokenEdit& edit, diff) {
+        edits << edit.oldIndex << edit.oldCount << edit.newIndex << edit.newCount;
+    }
+    QCOMPARE(edits, expectedEdits);
+}
@@ -24,6 +24,18 @@
 
 #include "documenttokenizertest.h"
 #include "documentlabelindextest.h"
+#include "linelexertest.h"
+#include "mnemonictabletest.h"
+#include "gapbuffertest.h"
+#include "textscannertest.h"
+#include "lineanchormaptest.h"
+#include "symboltabletest.h"
+#include "autocompletermodeltest.h"
+#include "completionenginetest.h"
+#include "syntaxhighlightertest.h"
+#include "editjournaltest.h"
+#include "fileloadertest.h"
+#include "documentsavertest.h"
 
 int main(int argc, char* argv[])
 {
@@ -33,5 +45,41 @@ int main(int argc, char* argv[])
     DocumentLabelIndexTest labelIndexTest;
     QTest::qExec(&labelIndexTest, argc, argv);
 
+    LineLexerTest lineLexerTest;
+    QTest::qExec(&lineLexerTest, argc, argv);
+
+    MnemonicTableTest mnemonicTableTest;
+    QTest::qExec(&mnemonicTableTest, argc, argv);
+
+    GapBufferTest gapBufferTest;
+    QTest::qExec(&gapBufferTest, argc, argv);
+
+    TextScannerTest textScannerTest;
+    QTest::qExec(&textScannerTest, argc, argv);
+
+    LineAnchorMapTest lineAnchorMapTest;
+    QTest::qExec(&lineAnchorMapTest, argc, argv);
+
+    SymbolTableTest symbolTableTest;
+    QTest::qExec(&symbolTableTest, argc, argv);
+
+    AutocompleterModelTest autocompleterModelTest;
+    QTest::qExec(&autocompleterModelTest, argc, argv);
+
+    CompletionEngineTest completionEngineTest;
+    QTest::qExec(&completionEngineTest, argc, argv);
+
+    SyntaxHighlighterTest syntaxHighlighterTest;
+    QTest::qExec(&syntaxHighlighterTest, argc, argv);
+
+    EditJournalTest editJournalTest;
+    QTest::qExec(&editJournalTest, argc, argv);
+
+    FileLoaderTest fileLoaderTest;
+    QTest::qExec(&fileLoaderTest, argc, argv);
+
+    DocumentSaverTest documentSaverTest;
+    QTest::qExec(&documentSaverTest, argc, argv);
+
     return 0;
 }
@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "mnemonictabletest.h"
+
+#include <QTest>
+
+#include <mnemonictable.h>
+#include <token.h>
+
+void MnemonicTableTest::testLookup_data()
+{
+    QTest::addColumn<QString>("word");
+    QTest::addColumn<int>("expectedOpcode");
+    QTest::addColumn<int>("expectedOperands");
+
+    QTest::newRow("halt") << "halt" << int(Mnemonic::Halt) << 0;
+    QTest::newRow("add") << "add" << int(Mnemonic::Add) << 3;
+    QTest::newRow("uppercase") << "CPFA" << int(Mnemonic::Cpfa) << 3;
+    QTest::newRow("mixed case") << "cPtA" << int(Mnemonic::Cpta) << 3;
+    QTest::newRow("not") << "not" << int(Mnemonic::Not) << 2;
+    QTest::newRow("call") << "call" << int(Mnemonic::Call) << 2;
+    QTest::newRow("ret") << "ret" << int(Mnemonic::Ret) << 1;
+    QTest::newRow("prefix") << "bn" << -1 << -1;
+    QTest::newRow("suffix") << "calls" << -1 << -1;
+    QTest::newRow("one letter") << "b" << -1 << -1;
+    QTest::newRow("empty") << "" << -1 << -1;
+    QTest::newRow("digits") << "4dd" << -1 << -1;
+    QTest::newRow("punctuation") << "a@d" << -1 << -1;
+    QTest::newRow("unicode") << "rét" << -1 << -1;
+}
+
+void MnemonicTableTest::testLookup()
+{
+    QFETCH(QString, word);
+    QFETCH(int, expectedOpcode);
+    QFETCH(int, expectedOperands);
+
+    const Mnemonic* mnemonic = MnemonicTable::lookup(word);
+    if (expectedOpcode < 0) {
+        QVERIFY(mnemonic == NULL);
+        return;
+    }
+
+    QVERIFY(mnemonic != NULL);
+    QCOMPARE(int(mnemonic->opcode), expectedOpcode);
+    QCOMPARE(mnemonic->numOperands, expectedOperands);
+    QCOMPARE(QString(mnemonic->name), word.toLower());
+}
+
+void MnemonicTableTest::testTable()
+{
+    const QStringList names = MnemonicTable::names();
+    QCOMPARE(names.size(), int(Mnemonic::NUM_OPCODES));
+
+    for (int i = 0; i < Mnemonic::NUM_OPCODES; ++i) {
+        const Mnemonic& mnemonic = MnemonicTable::at(static_cast<Mnemonic::Opcode>(i));
+        QCOMPARE(int(mnemonic.opcode), i);
+        QCOMPARE(QString(mnemonic.name), names[i]);
+        QCOMPARE(MnemonicTable::lookup(names[i]), &mnemonic);
+        QVERIFY(Token::REGEX[Token::Instruction].exactMatch(names[i]));
+    }
+}
+
+void MnemonicTableTest::testParity()
+{
+    // Every word of two to four letters from the letters used by the mnemonics
+    // must be recognized exactly when Token::REGEX[Instruction] matches it
+    const QString letters("abcdefhilmnoprstuvA");
+    QStringList words(letters.split(QString(), QString::SkipEmptyParts));
+    for (int length = 2; length <= MnemonicTable::MAX_LENGTH; ++length) {
+        QStringList longerWords;
+        foreach (const QString& word, words) {
+            if (word.length() != length - 1)
+                continue;
+            foreach (QChar c, letters) {
+                longerWords.push_back(word + c);
+            }
+        }
+        words.append(longerWords);
+    }
+
+    foreach (const QString& word, words) {
+        const bool isInstruction = Token::REGEX[Token::Instruction].exactMatch(word);
+        QCOMPARE(MnemonicTable::lookup(word) != NULL, isInstruction);
+    }
+}
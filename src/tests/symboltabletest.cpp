@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "symboltabletest.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QTest>
+
+#include <symboltable.h>
+
+void SymbolTableTest::testIntern()
+{
+    SymbolTable* symbols = SymbolTable::instance();
+
+    // The table is shared, so other tests may already have filled it
+    const int initialSize = symbols->size();
+
+    const SymbolId loop = symbols->intern("symboltabletest_loop");
+    const SymbolId end = symbols->intern("symboltabletest_end");
+    QVERIFY(loop != end);
+    QCOMPARE(symbols->size(), initialSize + 2);
+
+    // Interning a name again gives back the same id
+    QCOMPARE(symbols->intern("symboltabletest_loop"), loop);
+    QCOMPARE(symbols->intern(QString("symboltabletest_") + "end"), end);
+    QCOMPARE(symbols->size(), initialSize + 2);
+
+    QCOMPARE(symbols->name(loop), QString("symboltabletest_loop"));
+    QCOMPARE(symbols->name(end), QString("symboltabletest_end"));
+    QCOMPARE(symbols->find("symboltabletest_end"), end);
+
+    // Looking up a name never seen does not add it
+    QCOMPARE(symbols->find("symboltabletest_missing"), SymbolId(SymbolTable::NO_SYMBOL));
+    QCOMPARE(symbols->size(), initialSize + 2);
+    QVERIFY(symbols->name(SymbolTable::NO_SYMBOL).isNull());
+}
+
+void SymbolTableTest::testRelease()
+{
+    SymbolTable* symbols = SymbolTable::instance();
+    const int initialSize = symbols->size();
+
+    const SymbolId id = symbols->intern("symboltabletest_release");
+    QCOMPARE(symbols->intern("symboltabletest_release"), id);
+    QCOMPARE(symbols->size(), initialSize + 1);
+
+    // The name stays until its last use is given back
+    symbols->release(id);
+    QCOMPARE(symbols->find("symboltabletest_release"), id);
+    symbols->release(id);
+    QCOMPARE(symbols->find("symboltabletest_release"), SymbolId(SymbolTable::NO_SYMBOL));
+    QVERIFY(symbols->name(id).isNull());
+    QCOMPARE(symbols->size(), initialSize);
+
+    // Its id goes to the next new name
+    QCOMPARE(symbols->intern("symboltabletest_reused"), id);
+    QCOMPARE(symbols->name(id), QString("symboltabletest_reused"));
+    symbols->release(id);
+}
+
+namespace {
+
+SymbolId internName(const QString& name)
+{
+    return SymbolTable::instance()->intern(name);
+}
+
+}
+
+void SymbolTableTest::testConcurrentIntern()
+{
+    // Many threads interning overlapping names must agree on every id
+    QStringList names;
+    for (int i = 0; i < 20000; ++i) {
+        names.push_back(QString("symboltabletest_concurrent%1").arg(i % 500));
+    }
+
+    const QList<SymbolId> ids = QtConcurrent::blockingMapped(names, internName);
+    QCOMPARE(ids.size(), names.size());
+    for (int i = 0; i < names.size(); ++i) {
+        QCOMPARE(ids[i], SymbolTable::instance()->find(names[i]));
+        QCOMPARE(SymbolTable::instance()->name(ids[i]), names[i]);
+    }
+}
@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syntaxhighlightertest.h"
+
+#include <QTest>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextLayout>
+
+#include <documentlabelindex.h>
+#include <syntaxhighlighter.h>
+
+namespace {
+
+// Whether the text at column in line is drawn as an undefined label
+bool isMarkedBad(const SyntaxHighlighter& highlighter, QTextDocument& doc, int line, int column)
+{
+    const QTextBlock block = doc.findBlockByNumber(line);
+    foreach (const QTextLayout::FormatRange& range, block.layout()->formats()) {
+        if (range.start <= column && column < range.start + range.length)
+            return range.format == highlighter.charFormat(BadLabelFormat);
+    }
+    return false;
+}
+
+bool isHighlighted(QTextDocument& doc, int line)
+{
+    return !doc.findBlockByNumber(line).layout()->formats().isEmpty();
+}
+
+}
+
+void SyntaxHighlighterTest::testUsesFollowDefinitions()
+{
+    QTextDocument doc("\tcp\tfoo\tbar\n"
+                      "\tcp\tbar\tfoo\n"
+                      "bar\t0");
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+    SyntaxHighlighter highlighter(&doc, &index);
+    highlighter.rehighlight();
+
+    QVERIFY(isMarkedBad(highlighter, doc, 0, 4));
+    QVERIFY(!isMarkedBad(highlighter, doc, 0, 8));
+    QVERIFY(isMarkedBad(highlighter, doc, 1, 8));
+
+    // Defining foo redraws the lines that use it, and only those
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("\nfoo\t1");
+    QTRY_VERIFY(!isMarkedBad(highlighter, doc, 0, 4));
+    QVERIFY(!isMarkedBad(highlighter, doc, 1, 8));
+
+    // Removing bar marks its uses again
+    cursor.setPosition(doc.findBlockByNumber(2).position());
+    cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QTRY_VERIFY(isMarkedBad(highlighter, doc, 0, 8));
+    QVERIFY(isMarkedBad(highlighter, doc, 1, 4));
+    QVERIFY(!isMarkedBad(highlighter, doc, 0, 4));
+}
+
+void SyntaxHighlighterTest::testLazyHighlighting()
+{
+    QString docText;
+    for (int i = 0; i < 2000; ++i) {
+        docText.append("\tadd\t1\t2\t3\n");
+    }
+    QTextDocument doc(docText);
+    SyntaxHighlighter highlighter(&doc);
+
+    // Only the lines near the top are highlighted straight away
+    highlighter.setVisibleLines(0, 20);
+    highlighter.rehighlight();
+    QVERIFY(isHighlighted(doc, 0));
+    QVERIFY(isHighlighted(doc, 20));
+    QVERIFY(!isHighlighted(doc, 1000));
+    QVERIFY(highlighter.hasPendingBlocks());
+
+    // Scrolling to the middle highlights it on the spot
+    highlighter.setVisibleLines(1000, 1020);
+    QVERIFY(isHighlighted(doc, 1000));
+    QVERIFY(!isHighlighted(doc, 1999));
+
+    // and idle time takes care of the rest
+    QTRY_VERIFY(!highlighter.hasPendingBlocks());
+    QVERIFY(isHighlighted(doc, 1999));
+    QVERIFY(isHighlighted(doc, 500));
+}
+
+void SyntaxHighlighterTest::testHighlightThread()
+{
+    // With a label index, blocks out of sight are formatted on a thread
+    QString docText;
+    for (int i = 0; i < 3000; ++i) {
+        docText.append("\tcp\tfoo\tbar\n");
+    }
+    docText.append("foo\t0");
+    QTextDocument doc(docText);
+    QTextCursor cursor(&doc);
+    DocumentLabelIndex index(&doc);
+    SyntaxHighlighter highlighter(&doc, &index);
+
+    highlighter.setVisibleLines(0, 20);
+    highlighter.rehighlight();
+    QVERIFY(!isHighlighted(doc, 2000));
+    QTRY_VERIFY(!highlighter.hasPendingBlocks());
+
+    QVERIFY(isHighlighted(doc, 2000));
+    QVERIFY(!isMarkedBad(highlighter, doc, 2000, 4));
+    QVERIFY(isMarkedBad(highlighter, doc, 2000, 8));
+
+    // Defining bar redraws its uses off screen the same way
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("\nbar\t1");
+    QTRY_VERIFY(!isMarkedBad(highlighter, doc, 2000, 8));
+    QTRY_VERIFY(!highlighter.hasPendingBlocks());
+    QVERIFY(!isMarkedBad(highlighter, doc, 2999, 8));
+}
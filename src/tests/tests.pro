@@ -20,7 +20,7 @@
 # //                                                                                                          //
 # //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-QT       += core gui testlib
+QT       += core gui testlib concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -33,7 +33,19 @@ TEMPLATE = app
 
 SOURCES += main.cpp \
     documenttokenizertest.cpp \
-    documentlabelindextest.cpp
+    documentlabelindextest.cpp \
+    linelexertest.cpp \
+    mnemonictabletest.cpp \
+    gapbuffertest.cpp \
+    textscannertest.cpp \
+    lineanchormaptest.cpp \
+    symboltabletest.cpp \
+    autocompletermodeltest.cpp \
+    completionenginetest.cpp \
+    syntaxhighlightertest.cpp \
+    editjournaltest.cpp \
+    fileloadertest.cpp \
+    documentsavertest.cpp
 
 LIBS += -L../intellisense -lIntellisense
 
@@ -41,4 +53,16 @@ INCLUDEPATH += ../intellisense
 
 HEADERS += \
     documenttokenizertest.h \
-    documentlabelindextest.h
+    documentlabelindextest.h \
+    linelexertest.h \
+    mnemonictabletest.h \
+    gapbuffertest.h \
+    textscannertest.h \
+    lineanchormaptest.h \
+    symboltabletest.h \
+    autocompletermodeltest.h \
+    completionenginetest.h \
+    syntaxhighlightertest.h \
+    editjournaltest.h \
+    fileloadertest.h \
+    documentsavertest.h
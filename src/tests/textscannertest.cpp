@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                          //
+//  The MIT License (MIT)                                                                                   //
+//  Copyright (c) 2016 Benjamin Reeves                                                                      //
+//                                                                                                          //
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software           //
+//  and associated documentation files (the "Software"), to deal in the Software without restriction,       //
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,   //
+//  and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,   //
+//  subject to the following conditions:                                                                    //
+//                                                                                                          //
+//  The above copyright notice and this permission notice shall be included in all copies or substantial    //
+//  portions of the Software.                                                                               //
+//                                                                                                          //
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT   //
+//  LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.     //
+//  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, //
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     //
+//  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                                  //
+//                                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "textscannertest.h"
+
+#include <QTest>
+#include <QVector>
+
+#include <linelexer.h>
+#include <textscanner.h>
+
+Q_DECLARE_METATYPE(TextScanner::Kernel)
+
+namespace {
+
+// Builds a random string out of characters the scanner treats specially
+QString randomText(int length)
+{
+    static const ushort ALPHABET[] = {
+        ' ', '\t', '\n', '\r', '\v', '\f', '/', 'a', '0', '_', 0x08, 0x0E, 0x7F, 0x80, 0xA0, 0xE9, 0x2029
+    };
+    const int alphabetSize = sizeof(ALPHABET) / sizeof(ALPHABET[0]);
+
+    QString text;
+    text.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        text.append(QChar(qrand() % 3 == 0 ? ' ' : ALPHABET[qrand() % alphabetSize]));
+    }
+    return text;
+}
+
+QString sampleProgram(int numLines)
+{
+    static const char* LINES[] = {
+        "start   add     sum     sum     one     // running total",
+        "        cp      ptr     data",
+        "loop    be      done    count   zero",
+        "        sub     count   count   one",
+        "        be      loop    zero    zero",
+        "done    halt",
+        "",
+        "sum     .data   0",
+        "data    .data   'a'",
+        "one     .data   1       // constant"
+    };
+    const int numSamples = sizeof(LINES) / sizeof(LINES[0]);
+
+    QStringList lines;
+    for (int i = 0; i < numLines; ++i) {
+        lines.append(QLatin1String(LINES[i % numSamples]));
+    }
+    return lines.join('\n');
+}
+
+void addKernelRows()
+{
+    QTest::newRow("scalar") << TextScanner::Scalar;
+    if (TextScanner::isKernelSupported(TextScanner::SSE2))
+        QTest::newRow("sse2") << TextScanner::SSE2;
+    if (TextScanner::isKernelSupported(TextScanner::AVX2))
+        QTest::newRow("avx2") << TextScanner::AVX2;
+}
+
+} // namespace
+
+void TextScannerTest::testKernels()
+{
+    const TextScanner::Kernel best = TextScanner::kernel();
+
+    for (int i = 0; i < 2000; ++i) {
+        const QString text = randomText(qrand() % 80);
+        const QChar* const begin = text.constData();
+        const QChar* const end = begin + text.length();
+        const QChar* const from = begin + (text.isEmpty() ? 0 : qrand() % text.length());
+
+        TextScanner::setKernel(TextScanner::Scalar);
+        const QChar* const spaceEnd = TextScanner::skipAsciiSpaces(from, end);
+        const QChar* const wordBreak = TextScanner::findWordBreak(from, end);
+        const QChar* const newline = TextScanner::find(from, end, '\n');
+        const QChar* const separator = TextScanner::find(from, end, QChar::ParagraphSeparator);
+        const int numNewlines = TextScanner::count(begin, end, '\n');
+
+        for (int k = TextScanner::SSE2; k < TextScanner::NUM_KERNELS; ++k) {
+            const TextScanner::Kernel kernel = static_cast<TextScanner::Kernel>(k);
+            if (!TextScanner::isKernelSupported(kernel))
+                continue;
+
+            TextScanner::setKernel(kernel);
+            QCOMPARE(TextScanner::skipAsciiSpaces(from, end), spaceEnd);
+            QCOMPARE(TextScanner::findWordBreak(from, end), wordBreak);
+            QCOMPARE(TextScanner::find(from, end, '\n'), newline);
+            QCOMPARE(TextScanner::find(from, end, QChar::ParagraphSeparator), separator);
+            QCOMPARE(TextScanner::count(begin, end, '\n'), numNewlines);
+        }
+    }
+
+    TextScanner::setKernel(best);
+}
+
+void TextScannerTest::benchmarkCountLines_data()
+{
+    QTest::addColumn<bool>("split");
+    QTest::addColumn<TextScanner::Kernel>("kernel");
+
+    QTest::newRow("QStringRef::split") << true << TextScanner::Scalar;
+    addKernelRows();
+}
+
+void TextScannerTest::benchmarkCountLines()
+{
+    QFETCH(bool, split);
+    QFETCH(TextScanner::Kernel, kernel);
+
+    const QString text = sampleProgram(100000);
+    const TextScanner::Kernel best = TextScanner::kernel();
+    TextScanner::setKernel(kernel);
+
+    int numLines = 0;
+    QBENCHMARK {
+        if (split) {
+            numLines = QStringRef(&text).split('\n').size();
+        } else {
+            numLines = TextScanner::count(text.constData(), text.constData() + text.length(), '\n') + 1;
+        }
+    }
+    QCOMPARE(numLines, 100000);
+
+    TextScanner::setKernel(best);
+}
+
+void TextScannerTest::benchmarkTokenize_data()
+{
+    QTest::addColumn<bool>("regex");
+    QTest::addColumn<TextScanner::Kernel>("kernel");
+
+    QTest::newRow("regex") << true << TextScanner::Scalar;
+    addKernelRows();
+}
+
+void TextScannerTest::benchmarkTokenize()
+{
+    QFETCH(bool, regex);
+    QFETCH(TextScanner::Kernel, kernel);
+
+    const QStringList lines = sampleProgram(10000).split('\n');
+    const TextScanner::Kernel best = TextScanner::kernel();
+    TextScanner::setKernel(kernel);
+
+    QBENCHMARK {
+        foreach (const QString& line, lines) {
+            if (regex) {
+                LineLexer::tokenizeWithRegex(line);
+            } else {
+                LineLexer::tokenize(line);
+            }
+        }
+    }
+
+    TextScanner::setKernel(best);
+}